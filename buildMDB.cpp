@@ -11,8 +11,12 @@
 #include <stdexcept>
 #include <cstdlib>
 #include <thread>
+#include <algorithm>
+#include <iterator>
 #include "jtb/jtbstr.h"
 #include "jtb/jtbvec.h"
+#include "rowarena.h"
+#include "memtrack.h"
 
 
 enum { THREADLIMIT = 30000 };
@@ -20,16 +24,17 @@ enum { THREADLIMIT = 30000 };
 namespace fs = std::filesystem;
 using st = std::vector<std::string>::size_type;
 
+/* the single-valued fields point into the arena the rows were read into */
 struct Film {
-    JTB::Str tconst = "N\\a";
-    JTB::Str title = "N\\a";
-    JTB::Str origtitle = "N\\a";
-    JTB::Str year = "N\\a";
-    JTB::Str length = "N\\a";
-    JTB::Str genre = "N\\a";
-    JTB::Str rating = "0";
-    JTB::Str numrates = "0";
-    JTB::Str lang = "N\\a";
+    std::string_view tconst = "N\\a";
+    std::string_view title = "N\\a";
+    std::string_view origtitle = "N\\a";
+    std::string_view year = "N\\a";
+    std::string_view length = "N\\a";
+    std::string_view genre = "N\\a";
+    std::string_view rating = "0";
+    std::string_view numrates = "0";
+    std::string_view lang = "N\\a";
     JTB::Str directors = "";
     JTB::Str writers = "";
     JTB::Str actors = "";
@@ -47,7 +52,7 @@ int icast(T thing) {
 
 const int nofdsets = 5;
 
-void loadBasics(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestream) {
+void loadBasics(std::map<std::string_view, Film>& film_hashmap, RowArena& arena, std::ifstream& filestream) {
     /* throwing out the first line */
     JTB::Str buf {};
     buf.absorbLine(filestream).clear();
@@ -61,14 +66,15 @@ void loadBasics(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestrea
     int count = 0;
 
     while ( filestream.good() && !buf.clear().absorbLine(filestream).isEmpty() ) {
-	JTB::Vec<JTB::Str> rowslicer = buf.split("\t");
+	auto mark = arena.mark();
+	Fields rowslicer = arena.split(buf.stdstr());
 	try {
-	    if (rowslicer[TYPE] == "movie" 
-		&& rowslicer[ISADULT] == "0"
-		&& rowslicer[STARTYEAR] != R"(\N)" 
-		&& rowslicer[RUNTIME] != R"(\N)") {
+	    if (rowslicer.at(TYPE) == "movie" 
+		&& rowslicer.at(ISADULT) == "0"
+		&& rowslicer.at(STARTYEAR) != R"(\N)" 
+		&& rowslicer.at(RUNTIME) != R"(\N)") {
 
-		threadPack.emplace_back([&, rowslicer]() {
+		threadPack.emplace_back(memtrack::inherit([&, rowslicer]() {
 		    Film film; 
 		    film.tconst = rowslicer.at(TCONST);
 		    film.title = rowslicer.at(PRIMARY);
@@ -78,7 +84,7 @@ void loadBasics(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestrea
 		    film.genre = rowslicer.at(GENRES);
 		    std::lock_guard<std::mutex> lock(mutex);
 		    film_hashmap[film.tconst] = film;
-		});
+		}));
 		if ((++count)%THREADLIMIT == 0) {
 		    for (auto& thread : threadPack) {
 			thread.join();
@@ -86,6 +92,8 @@ void loadBasics(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestrea
 		    threadPack.clear();
 		}
 	    }
+	    /* rows we don't keep give their space straight back */
+	    else arena.rewind(mark);
 	} catch (std::exception e) {
 	    std::cerr << "Error reading basics: " << e.what() << '\n';
 	    std::cerr << "Count: " << count << '\n';
@@ -99,9 +107,10 @@ void loadBasics(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestrea
     std::cout << "Done reading the basics!" << '\n';
 }
 
-void loadRatings(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestream) {
+void loadRatings(std::map<std::string_view, Film>& film_hashmap, RowArena& arena, std::ifstream& filestream) {
     /* buffers */
-    JTB::Vec<JTB::Str> rowslicer {};
+    RowArena scratch {};
+    Fields rowslicer {};
     JTB::Str buf {};
 
     /* throwing out first line */
@@ -110,11 +119,12 @@ void loadRatings(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestre
 
     /* reading ratings into fdb */
     while ( filestream.good() && !buf.clear().absorbLine(filestream).isEmpty() ) {
-        rowslicer = buf.split("\t");
+        rowslicer = scratch.clear().split(buf.stdstr());
 	try {
-	    if (film_hashmap.contains(rowslicer[TCONST])) {
-		film_hashmap[rowslicer[TCONST]].rating = rowslicer[RATING];
-		film_hashmap[rowslicer[TCONST]].numrates = rowslicer[NUMRATES];
+	    auto film = film_hashmap.find(rowslicer.at(TCONST));
+	    if (film != film_hashmap.end()) {
+		film->second.rating = arena.copy(rowslicer.at(RATING));
+		film->second.numrates = arena.copy(rowslicer.at(NUMRATES));
 	    }
 	} catch (std::exception e) { 
 	    std::cerr << "Problem inserting ratings" << '\n';
@@ -126,9 +136,10 @@ void loadRatings(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestre
     std::cout << "Done reading ratings!" << '\n';
 }
 
-void loadLanguage(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestream) {
+void loadLanguage(std::map<std::string_view, Film>& film_hashmap, RowArena& arena, std::ifstream& filestream) {
     /* buffers */
-    JTB::Vec<JTB::Str> rowslicer {};
+    RowArena scratch {};
+    Fields rowslicer {};
     JTB::Str buf {};
 
     enum Cols { TCONST, LANG };
@@ -136,11 +147,11 @@ void loadLanguage(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestr
     /* reading langs into buffer */
     int count = 0;
     while ( filestream.good() && !buf.clear().absorbLine(filestream).isEmpty() ) {
-        rowslicer = buf.split("\t");
+        rowslicer = scratch.clear().split(buf.stdstr());
 	if (rowslicer.size() < 2) continue; 
 	try { 
 	    if (film_hashmap.contains(rowslicer[TCONST])) {
-		film_hashmap.at(rowslicer[TCONST]).lang = rowslicer[LANG];
+		film_hashmap.at(rowslicer[TCONST]).lang = arena.copy(rowslicer[LANG]);
 	    }
 	} catch (std::out_of_range e) { 
 	    std::cerr << "Problem inserting languages" << '\n';
@@ -154,13 +165,14 @@ void loadLanguage(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& filestr
 
 };
 
-void loadPrincipals(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& principals_stream, std::ifstream& names_stream) {
+void loadPrincipals(std::map<std::string_view, Film>& film_hashmap, RowArena& arena, std::ifstream& principals_stream, std::ifstream& names_stream) {
     /* buffers */
-    JTB::Vec<JTB::Str> rowslicer {};
+    RowArena scratch {};
+    Fields rowslicer {};
     JTB::Str buf {};
 
-    /* buffer for names */
-    std::map<JTB::Str, JTB::Str> namebuf {};
+    /* buffer for names (only the two fields we use are kept in the arena) */
+    std::map<std::string_view, Field> namebuf {};
 
     enum class Names { NCONST, NAME };
     enum class Principles { TCONST, ORDERING, NCONST, CATEGORY, JOB, CHARACTERS };
@@ -168,34 +180,89 @@ void loadPrincipals(std::map<JTB::Str, Film>& film_hashmap, std::ifstream& princ
 
     /* reading names into buffer */
     while (names_stream.good() && !buf.clear().absorbLine(names_stream).isEmpty()) {
-        rowslicer = buf.split("\t");
+        rowslicer = scratch.clear().split(buf.stdstr());
 	if (rowslicer.size() < 2) continue;
-	namebuf[rowslicer[static_cast<int>(Names::NCONST)]] = rowslicer[static_cast<int>(Names::NAME)];
+	namebuf[arena.copy(rowslicer[static_cast<int>(Names::NCONST)])] = arena.copy(rowslicer[static_cast<int>(Names::NAME)]);
     }
     std::cout << "Done reading names!" << '\n';
 
     /* filling in principals */
     buf.absorbLine(principals_stream);
     while (principals_stream.good() && !buf.clear().absorbLine(principals_stream).isEmpty()) {
-	rowslicer = buf.split("\t");
+	rowslicer = scratch.clear().split(buf.stdstr());
 	if (rowslicer.size() < 4) continue;
-	if (!film_hashmap.contains(rowslicer[icast(Principles::TCONST)])) continue;
+	auto film = film_hashmap.find(rowslicer[icast(Principles::TCONST)]);
+	if (film == film_hashmap.end()) continue;
+	auto name = namebuf.find(rowslicer.at(icast(Principles::NCONST)));
+	const char* credit = name == namebuf.end() ? "" : name->second.c_str();
 	if (rowslicer.at(icast(Principles::CATEGORY)).startsWith("a")) {
-	    film_hashmap[rowslicer.at(icast(Principles::TCONST))].actors 
-		= film_hashmap[rowslicer.at(icast(Principles::TCONST))].actors + namebuf[rowslicer.at(icast(Principles::NCONST))] + ',';
+	    film->second.actors.push(credit);
+	    film->second.actors.push(",");
 	}
 	else if (rowslicer.at(icast(Principles::CATEGORY)).startsWith("d")) {
-	    film_hashmap[rowslicer.at(icast(Principles::TCONST))].directors 
-		= film_hashmap[rowslicer.at(icast(Principles::TCONST))].directors + namebuf[rowslicer.at(icast(Principles::NCONST))] + ',';
+	    film->second.directors.push(credit);
+	    film->second.directors.push(",");
 	}
 	else if (rowslicer.at(icast(Principles::CATEGORY)).startsWith("w")) {
-	    film_hashmap[rowslicer.at(icast(Principles::TCONST))].writers 
-		= film_hashmap[rowslicer.at(icast(Principles::TCONST))].writers + namebuf[rowslicer.at(icast(Principles::NCONST))] + ',';
+	    film->second.writers.push(credit);
+	    film->second.writers.push(",");
 	}
     }
     std::cout << "Done reading principals!" << '\n';
 }
 
+/* formats the rated films the way main always printed them, one movies.tsv line per film */
+void formatFilm(std::string& out, const Film& film) {
+    char tab = '\t';
+    out.append(film.tconst).push_back(tab);
+    out.append(film.title).push_back(';');
+    out.append(film.origtitle).push_back(tab);
+    out.append(film.year).push_back(tab);
+    out.append(film.length).push_back(tab);
+    out.append(film.genre).push_back(tab);
+    out.append(film.rating).push_back(tab);
+    out.append(film.numrates).push_back(tab);
+    out.append(film.lang).push_back(tab);
+    out.append(film.directors.stdstr()).push_back(tab);
+    out.append(film.actors.stdstr()).push_back(tab);
+    out.append(film.writers.stdstr()).push_back('\n');
+}
+
+/* each thread formats a contiguous slice of the map into its own buffer; the slices
+ * are written in key order as they finish, so the file comes out exactly as the old
+ * field-by-field stream did <== 10/19/26 13:58:20 */
+void writeMovies(const std::map<std::string_view, Film>& fdata, const std::string& path) {
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t perSlice = (fdata.size() + threads - 1) / threads;
+
+    std::vector<std::map<std::string_view, Film>::const_iterator> bounds { fdata.begin() };
+    size_t count = 0;
+    for (auto it = fdata.begin(); it != fdata.end(); ++it) {
+	if (count > 0 && count % perSlice == 0) bounds.push_back(it);
+	++count;
+    }
+    bounds.push_back(fdata.end());
+
+    std::vector<std::string> buffers (bounds.size() - 1);
+    std::vector<std::thread> threadPack {};
+    for (size_t slice = 0; slice + 1 < bounds.size(); ++slice) {
+	threadPack.emplace_back(memtrack::inherit([&, slice]() {
+	    std::string& out = buffers[slice];
+	    out.reserve(std::distance(bounds[slice], bounds[slice+1]) * 160);
+	    for (auto it = bounds[slice]; it != bounds[slice+1]; ++it) {
+		if (it->second.numrates != "0") formatFilm(out, it->second);
+	    }
+	}));
+    }
+
+    std::ofstream os { path, std::ios::binary };
+    for (size_t slice = 0; slice < threadPack.size(); ++slice) {
+	threadPack[slice].join();
+	os.write(buffers[slice].data(), buffers[slice].size());
+	std::string().swap(buffers[slice]);
+    }
+}
+
 int main() {
 
     /* reading the directory and opening the relevant files if they're found */
@@ -238,24 +305,16 @@ int main() {
 	exit(1);
     }
 
-    std::map<JTB::Str, Film> fdata {};
-
-    loadBasics(fdata, basics_stream);
-    loadRatings(fdata, ratings_stream);
-    loadLanguage(fdata, lang_stream);
-    loadPrincipals(fdata, principals_stream, name_basics_stream);
+    /* every string fdata points at lives in here until the output is written */
+    RowArena arena {};
+    std::map<std::string_view, Film> fdata {};
 
-    std::ofstream os { moviesWithPath.str() };
+    { memtrack::Stage scope { "basics" }; loadBasics(fdata, arena, basics_stream); }
+    { memtrack::Stage scope { "ratings" }; loadRatings(fdata, arena, ratings_stream); }
+    { memtrack::Stage scope { "lang" }; loadLanguage(fdata, arena, lang_stream); }
+    { memtrack::Stage scope { "principals" }; loadPrincipals(fdata, arena, principals_stream, name_basics_stream); }
 
-    char tab = '\t';
-
-    for (auto const& [k, film] : fdata) {
-	if (film.numrates != "0") {
-	    os << film.tconst << tab << film.title << ";" << film.origtitle << tab; 
-	    os << film.year << tab << film.length << tab << film.genre << tab; 
-	    os << film.rating << tab << film.numrates << tab << film.lang << tab << film.directors << tab;
-	    os << film.actors << tab << film.writers << '\n';
-	}
-    }
+    { memtrack::Stage scope { "export" }; writeMovies(fdata, moviesWithPath.str()); }
+    memtrack::report(std::cerr);
     std::cout << "All done!" << '\n';
 }
@@ -10,230 +10,428 @@
 #include <filesystem>
 #include <memory>
 #include <cstdlib>
+#include <cctype>
 #include <thread>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+#include <map>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <array>
+#include <numeric>
+#include <unistd.h>
 #include "jtb/jtbstr.h"
 #include "jtb/jtbvec.h"
+#include "rowarena.h"
+#include "imdbid.h"
+#include "tsvtable.h"
+#include "tables.h"
+#include "memtrack.h"
+#include "linereader.h"
 #include <SQLiteCpp/SQLiteCpp.h>
-#include "progressbar/include/progressbar.hpp"
 
 
 const int THREADLIMIT = 4;
 const int PRINCIPLES_BATCH_SIZE = 5000000;
 const bool VERBOSE = false;
-const int LOGGING_FACTOR = 4000;
 
 namespace fs = std::filesystem;
 using st = std::vector<std::string>::size_type;
 
 
-class Pbar {
-private: 
-    progressbar pbar;
+/* per-thread row counters for one stage. each worker bumps only its own cache line,
+ * so counting never contends and never waits on the terminal <== 10/19/26 10:05:52 */ 
+class Progress {
+private:
+    struct alignas(64) Slot { std::atomic<long> count {0}; };
+    std::array<Slot, THREADLIMIT> slots {};
+    std::atomic<bool> finished {false};
+    /* how far through the input, for a stage whose total is the input's size in bytes */
+    std::atomic<long> position {-1};
 public:
-    Pbar(int total): pbar(total) {};
-    void update() { pbar.update(); }
-    void reset() { pbar.reset(); }
-    void set_niter(int n) { pbar.set_niter(n); }
+    const std::string name;
+    const long total;
+    const std::chrono::steady_clock::time_point started { std::chrono::steady_clock::now() };
+    std::chrono::steady_clock::time_point stopped {};
+
+    Progress(const std::string& name, long total): name(name), total(total) {};
+    void add(int threadnum, long n = 1) { slots[threadnum % THREADLIMIT].count.fetch_add(n, std::memory_order_relaxed); }
+    long done() const {
+	long sum {0};
+	for (auto& slot : slots) sum += slot.count.load(std::memory_order_relaxed);
+	return sum;
+    }
+    void reached(long offset) { position.store(offset, std::memory_order_relaxed); }
+    /* what the percentage is measured by: bytes if reached() has been called, else rows */
+    long through() const {
+	long at { position.load(std::memory_order_relaxed) };
+	return at >= 0 ? at : done();
+    }
+    void finish() { stopped = std::chrono::steady_clock::now(); finished.store(true, std::memory_order_release); }
+    bool isFinished() const { return finished.load(std::memory_order_acquire); }
 };
 
+/* the one thread that samples every stage's counters and renders them: a bar on a tty,
+ * otherwise one "progress ..." line per stage every few seconds */
+class ProgressReporter {
+private:
+    JTB::Vec<std::shared_ptr<Progress>> tracked {};
+    std::mutex mutex {};
+    std::condition_variable cv {};
+    std::thread sampler {};
+    bool stopping {false};
+    bool tty { isatty(STDERR_FILENO) == 1 };
+
+    static double seconds(const Progress& p, std::chrono::steady_clock::time_point now) {
+	return std::chrono::duration<double>(now - p.started).count();
+    }
+
+    void render(bool final) {
+	auto now = std::chrono::steady_clock::now();
+	JTB::Vec<std::shared_ptr<Progress>> active {};
+	std::stringstream line {};
+	for (auto& p : tracked) {
+	    if (p->isFinished()) {
+		double secs { seconds(*p, p->stopped) };
+		if (tty) std::cerr << "\r\033[K";
+		std::cerr << "stage=" << p->name << " rows=" << p->done() << " seconds=" << secs 
+		    << " rate=" << static_cast<long>(p->done()/std::max(secs, 1e-3)) << '\n';
+		continue;
+	    }
+	    active.push(p);
+	    long done { p->done() };
+	    double pct { p->total > 0 ? std::min(100.0, 100.0*p->through()/p->total) : 0.0 };
+	    long rate { static_cast<long>(done/std::max(seconds(*p, now), 1e-3)) };
+	    if (tty) {
+		int filled { static_cast<int>(pct/5) };
+		line << p->name << " [" << std::string(filled, '#') << std::string(20 - filled, '-') << "] " 
+		    << static_cast<int>(pct) << "% " << rate << "/s  ";
+	    }
+	    else if (!final) {
+		std::cerr << "progress stage=" << p->name << " done=" << p->through() << " total=" << p->total 
+		    << " pct=" << pct << " rate=" << rate << '\n';
+	    }
+	}
+	if (tty && !final) std::cerr << "\r\033[K" << line.str() << std::flush;
+	tracked = std::move(active);
+    }
+public:
+    void start() {
+	sampler = std::thread([&](){
+	    std::unique_lock<std::mutex> lock { mutex };
+	    while (!stopping) {
+		cv.wait_for(lock, tty ? std::chrono::milliseconds(200) : std::chrono::seconds(5));
+		render(stopping);
+	    }
+	});
+    }
+    void stop() {
+	{
+	    std::lock_guard<std::mutex> lock { mutex };
+	    stopping = true;
+	}
+	cv.notify_all();
+	if (sampler.joinable()) sampler.join();
+    }
+    /* a stage that gives up calls exit(), which destroys this while the sampler is still
+     * running; a joinable thread's destructor would terminate() instead of exiting with 1 */
+    ~ProgressReporter() { stop(); }
+    std::shared_ptr<Progress> track(const std::string& name, long total) {
+	auto progress = std::make_shared<Progress>(name, total);
+	std::lock_guard<std::mutex> lock { mutex };
+	tracked.push(progress);
+	return progress;
+    }
+};
+
+ProgressReporter reporter {};
+
 template <typename T>
 int icast(T thing) {
     return static_cast<int>(thing);
 }
 
+/* the tconsts (or nconsts) that made it in, as a bitset over the numeric part of the id.
+ * rows pointing anywhere else can never satisfy the foreign keys, so they're dropped at
+ * parse time instead of costing a statement step and an exception each <== 10/19/26 11:48:05 */ 
+class IdSet {
+private:
+    std::vector<uint64_t> bits {};
+    long count {0};
+public:
+    void insert(std::string_view id) {
+	long n = idNumber(id);
+	if (n < 0) return;
+	if (static_cast<size_t>(n/64) >= bits.size()) bits.resize(n/64 + 1 + bits.size()/2, 0);
+	if (!(bits[n/64] & (uint64_t{1} << (n%64)))) ++count;
+	bits[n/64] |= uint64_t{1} << (n%64);
+    }
+    bool contains(std::string_view id) const {
+	long n = idNumber(id);
+	return n >= 0 && static_cast<size_t>(n/64) < bits.size() && (bits[n/64] & (uint64_t{1} << (n%64)));
+    }
+    long size() const { return count; }
+
+    /* for runs that skip the stage that would have filled the set */
+    void loadFrom(SQLite::Database& db, const char* query) {
+	SQLite::Statement select { db, query };
+	while (select.executeStep()) insert(select.getColumn(0).getString());
+    }
+};
+
+/* every film that passes the basics filter, and every name in name.basics */
+IdSet films {};
+IdSet people {};
+
+/* a batch of parsed rows and the arena they live in; dropping the batch frees them all at once */
+class Batch {
+private:
+    RowArena arena {};
+    JTB::Vec<Fields> rows {};
+    int turnedDown {0};
+public:
+    /* splits line into the arena; keep (if given) can still turn the row down */
+    void push(std::string_view line, const std::function<bool(const Fields&)>& keep = nullptr) {
+	auto mark = arena.mark();
+	Fields rowslicer = arena.split(line);
+	if (keep && !keep(rowslicer)) {
+	    arena.rewind(mark);
+	    ++turnedDown;
+	    return;
+	}
+	rows.push(rowslicer);
+    }
+    const Fields& at(int i) const { return rows.at(i); }
+    int size() const { return rows.size(); }
+    int dropped() const { return turnedDown; }
+    /* where in the file this batch ended */
+    long endOffset {0};
+};
+
+/* where thread threadnum's share of size rows starts; the last share runs to size */
+int chunkStart(int size, int threadnum) {
+    return static_cast<int>(static_cast<long>(size) * threadnum / THREADLIMIT);
+}
+
+/* the rows of a batch in key order (less compares two row numbers), rows with equal keys
+ * staying in file order. THREADLIMIT chunks are sorted at once and then merged. the
+ * loaders sort on idLess, the order the dumps come in, so one batch carries on where the
+ * last one stopped and each table's key b-tree is only appended to. sqlite compares text
+ * keys like memcmp, which puts "tt10000000" just after "tt1000000": the longer ids make
+ * a second append point, not a split page per row <== 10/19/26 15:40:18 */
+template <typename Less>
+std::vector<int> sortedRows(int size, Less less) {
+    std::vector<int> order (size);
+    std::iota(order.begin(), order.end(), 0);
+    JTB::Vec<std::thread> threadPack {};
+    for (int threadnum = 0; threadnum < THREADLIMIT; ++threadnum) {
+	threadPack.push(memtrack::inherit([&,threadnum](){
+	    std::stable_sort(order.begin() + chunkStart(size, threadnum), order.begin() + chunkStart(size, threadnum+1), less);
+	}));
+    }
+    threadPack.forEach([&](std::thread& thread) {
+	if (thread.joinable()) {
+	    thread.join();
+	}
+    });
+    for (int width = 1; width < THREADLIMIT; width *= 2) {
+	for (int threadnum = 0; threadnum + width < THREADLIMIT; threadnum += 2*width) {
+	    std::inplace_merge(order.begin() + chunkStart(size, threadnum), order.begin() + chunkStart(size, threadnum + width),
+		order.begin() + chunkStart(size, std::min(threadnum + 2*width, static_cast<int>(THREADLIMIT))), less);
+	}
+    }
+    return order;
+}
+
+/* batches are only sorted within themselves. one starting below where the previous one
+ * ended (the file isn't in id order) gets a warning, since from there that table's
+ * inserts stop being appends */
+void checkBatchOrder(const std::string& stage, const std::string& first, std::string& last, const std::string& batchLast) {
+    if (!last.empty() && idLess(first, last)) {
+	std::cerr << "Warning: " << stage << " batch starts at " << first << ", below the previous batch's " << last 
+	    << "; inserts into its tables are no longer in key order" << '\n';
+    }
+    last = batchLast;
+}
+
+/* columns of title.basics.tsv, title.principals.tsv and name.basics.tsv <== 10/19/26 09:12:40 */ 
+enum class Basics { TCONST, TYPE, PRIMARY, ORIGINAL, ISADULT, STARTYEAR, ENDYEAR, RUNTIME, GENRES };
+enum class Names { NCONST, NAME };
+enum class Principles { TCONST, ORDERING, NCONST, CATEGORY, JOB, CHARACTERS };
+
+/* the principals categories that get loaded, by first letter as buildMDB.cpp has it, so
+ * archive_footage and archive_sound go into Actors along with actor and actress */
+enum class Credit { NONE, ACTOR, DIRECTOR, WRITER };
+Credit creditOf(const Field& category) {
+    if (category.startsWith("a")) return Credit::ACTOR;
+    if (category.startsWith("d")) return Credit::DIRECTOR;
+    if (category.startsWith("w")) return Credit::WRITER;
+    return Credit::NONE;
+}
+
 class Filebuffer {
 private:
-    JTB::Vec<JTB::Vec<JTB::Str>>* buffer {};
-    int chunksize {0};
+    Batch* buffer {};
 public:
-    Filebuffer(std::ifstream& filestream) {
-	JTB::Str buf {};
-	JTB::Vec<JTB::Str> rowslicer {};
-	buffer = new JTB::Vec<JTB::Vec<JTB::Str>>;
-	while ( filestream.good() && !buf.clear().absorbLine(filestream).isEmpty() ) {
-	    rowslicer = buf.split("\t");
-	    buffer->push(rowslicer);
+    /* keep (if given) decides which rows make it into the buffer */
+    Filebuffer(LineReader& reader, std::function<bool(const Fields&)> keep = nullptr) {
+	buffer = new Batch;
+	std::string_view line {};
+	while (reader.next(line)) {
+	    if (!line.empty()) buffer->push(line, keep);
 	}
-	chunksize = buffer->size()/THREADLIMIT;
     };
     ~Filebuffer() { delete buffer; };
     auto& getBuf() { return *buffer; }
-    int getChunksize() { return chunksize; }
+    int chunkStart(int threadnum) { return ::chunkStart(buffer->size(), threadnum); }
     int getSize() { return buffer->size(); }
+    int getDropped() { return buffer->dropped(); }
 };
 
-void loadBasics(SQLite::Database& db, std::ifstream& filestream) {
+std::unique_ptr<Filebuffer> readBasics(const std::string& path) {
     /* throwing out the first line */
-    JTB::Str buf {};
-    buf.absorbLine(filestream).clear();
-    
-    /* enum for rowslicer <== 11/29/24 10:56:34 */ 
-    enum Cols { TCONST, TYPE, PRIMARY, ORIGINAL, ISADULT, STARTYEAR, ENDYEAR, RUNTIME, GENRES };
-
-    std::unique_ptr<JTB::Vec<JTB::Vec<JTB::Str>>> filebuffer {new JTB::Vec<JTB::Vec<JTB::Str>>};
-
-    /* processing the data */
-    while ( filestream.good() && !buf.clear().absorbLine(filestream).isEmpty() ) {
-	JTB::Vec<JTB::Str> rowslicer = buf.split("\t");
-	if (rowslicer[TYPE].startsWith("mo")
-	    && rowslicer[ISADULT] == "0"
-	    && rowslicer[STARTYEAR] != R"(\N)" 
-	    && rowslicer[GENRES] != R"(\N)" 
-	    && rowslicer[RUNTIME] != R"(\N)") {
-	    (*filebuffer).push(rowslicer);
+    LineReader reader { path };
+    std::string_view header {};
+    reader.next(header);
+
+    /* only feature films with the fields we need make it into the buffer */
+    return std::make_unique<Filebuffer>(reader, [](const Fields& rowslicer) {
+	bool keep = rowslicer.size() > icast(Basics::GENRES)
+	    && rowslicer[icast(Basics::TYPE)].startsWith("mo")
+	    && rowslicer[icast(Basics::ISADULT)] == "0"
+	    && rowslicer[icast(Basics::STARTYEAR)] != R"(\N)" 
+	    && rowslicer[icast(Basics::GENRES)] != R"(\N)" 
+	    && rowslicer[icast(Basics::RUNTIME)] != R"(\N)";
+	if (!keep) return false;
+	/* a tconst seen already keeps its first row, as a plain INSERT into Films would; the
+	 * repeat's years, runtimes and genres go with it */
+	if (films.contains(rowslicer[icast(Basics::TCONST)])) {
+	    if (VERBOSE) std::cerr << "Problem reading basics: " << rowslicer[icast(Basics::TCONST)] << " appears twice" << '\n';
+	    return false;
 	}
-    }
+	films.insert(rowslicer[icast(Basics::TCONST)]);
+	return true;
+    });
+}
 
-    JTB::Vec<std::thread> threadPack {};
-    int size = (*filebuffer).size();
-    int chunksize = (*filebuffer).size()/THREADLIMIT;
-    Pbar pbar(size/LOGGING_FACTOR);
-    std::mutex mutex {};
+void loadBasics(SQLite::Database& db, Filebuffer& basics) {
+    enum Cols { TCONST, TYPE, PRIMARY, ORIGINAL, ISADULT, STARTYEAR, ENDYEAR, RUNTIME, GENRES };
 
-    for (int threadnum=0; threadnum < THREADLIMIT; ++threadnum) {
-	threadPack.push([&,threadnum](){
-	    SQLite::Statement film_insert {db, "INSERT INTO Films (tconst, title, originalTitle) VALUES (?, ?, ?)" };
-	    SQLite::Statement year_insert {db, "INSERT INTO Years (tconst, year) VALUES (?, ?)" };
-	    SQLite::Statement runtime_insert {db, "INSERT INTO Runtimes (tconst, runtimeInMin) VALUES (?, ?)" };
-	    SQLite::Statement genre_insert {db, "INSERT INTO Genres (tconst, genre) VALUES (?, ?)" };
-	    int start = chunksize*(threadnum);
-	    int stop = chunksize*(threadnum+1);
-	    for (int line = start; line < std::min(stop,size); ++line) {
+    Batch& filebuffer { basics.getBuf() };
+    int size = filebuffer.size();
+    auto progress = reporter.track("basics", size);
 
-		if (line%LOGGING_FACTOR == 0) {
-		    std::lock_guard<std::mutex> lock { mutex };
-		    pbar.update();
-		}
+    /* Films and the tables hanging off it all go in tconst order, from this one thread */
+    std::vector<int> order { sortedRows(size, [&](int a, int b) {
+	return idLess(filebuffer.at(a)[TCONST].view(), filebuffer.at(b)[TCONST].view());
+    }) };
 
-		/* std::cerr << threadnum << " : " << (float(line-start)/chunksize)*100 << '\n'; */
-		try {
-		    film_insert.reset();
-		    film_insert.bind(1, (*filebuffer).at(line).at(TCONST).c_str());
-		    film_insert.bind(2, (*filebuffer).at(line).at(PRIMARY).c_str());
-		    film_insert.bind(3, (*filebuffer).at(line).at(ORIGINAL).c_str());
-		    year_insert.reset();
-		    year_insert.bind(1, (*filebuffer).at(line).at(TCONST).c_str());
-		    year_insert.bind(2, (*filebuffer).at(line).at(STARTYEAR).c_str());
-		    runtime_insert.reset();
-		    runtime_insert.bind(1, (*filebuffer).at(line).at(TCONST).c_str());
-		    runtime_insert.bind(2, std::stoi((*filebuffer).at(line).at(RUNTIME).c_str()));
-		    film_insert.exec();
-		    year_insert.exec();
-		    runtime_insert.exec();
-		    JTB::Vec<JTB::Str> genres = (*filebuffer).at(line).at(GENRES).split(",");
-		    genres.forEach([&](JTB::Str genre) {
-			    genre_insert.reset();
-			    genre_insert.bind(1, (*filebuffer).at(line).at(TCONST).c_str());
-			    genre_insert.bind(2, genre.c_str());
-			    genre_insert.exec();
-		    });
-		} catch (SQLite::Exception& e) {
-		    if (VERBOSE) {
-			std::cerr << "Problem reading basics: " << e.what() << '\n';
-			std::cerr << "Rowslicer: " << (*filebuffer).at(line) << '\n';
-		    }
-		} catch (std::exception& e) {
-		    std::cerr << "Error reading basics: " << e.what() << '\n';
-		    std::cerr << "Rowslicer: " << (*filebuffer).at(line) << '\n';
-		    exit(1);
-		}
-	    }
-	});
-    }
-    threadPack.forEach([&](std::thread& thread){
-	if (thread.joinable()) {
-	    thread.join();
+    auto onReject = [](const SQLite::Exception& e) {
+	if (VERBOSE) std::cerr << "Problem reading basics: " << e.what() << '\n';
+    };
+    /* a reload updates the films already there; the credits, ratings and languages loaded
+     * against them keep pointing at the same rows */
+    BatchInsert<FilmsTable, 64, OnConflict::UPDATE> film_insert { db, onReject };
+    BatchInsert<YearsTable> year_insert { db, onReject, &film_insert };
+    BatchInsert<RuntimesTable> runtime_insert { db, onReject, &film_insert };
+    BatchInsert<GenresTable> genre_insert { db, onReject, &film_insert };
+    /* the genres are pieces of one field, so they get their own null-terminated copies */
+    RowArena genres {};
+    for (int line : order) {
+	progress->add(0);
+	try {
+	    const Fields& row = filebuffer.at(line);
+	    Text tconst = row.at(TCONST).c_str();
+	    film_insert.add({ tconst, row.at(PRIMARY).c_str(), row.at(ORIGINAL).c_str() });
+	    year_insert.add({ tconst, std::stoi(row.at(STARTYEAR).c_str()) });
+	    runtime_insert.add({ tconst, std::stoi(row.at(RUNTIME).c_str()) });
+	    row.at(GENRES).forEachPart(',', [&](std::string_view genre) {
+		    genre_insert.add({ tconst, genres.copy(genre).c_str() });
+	    });
+	} catch (std::exception& e) {
+	    std::cerr << "Error reading basics: " << e.what() << '\n';
+	    std::cerr << "Rowslicer: " << filebuffer.at(line) << '\n';
+	    exit(1);
 	}
-    });
+    }
+    film_insert.flush();
+    year_insert.flush();
+    runtime_insert.flush();
+    genre_insert.flush();
+    progress->finish();
     std::cerr << "\nDone reading the basics!" << '\n';
 }
 
-void loadRatings(SQLite::Database& db, std::ifstream& filestream) {
-    /* buffers */
-    JTB::Str buf {};
-
+std::unique_ptr<Filebuffer> readRatings(const std::string& path) {
     /* throwing out first line */
-    buf.absorbLine(filestream).clear();
-
-    enum Cols { TCONST, RATING, NUMRATES };
+    LineReader reader { path };
+    std::string_view header {};
+    reader.next(header);
+    return std::make_unique<Filebuffer>(reader, [](const Fields& rowslicer) {
+	return rowslicer.size() >= 3 && films.contains(rowslicer[0]);
+    });
+}
 
-    JTB::Vec<std::thread> threadPack {};
+std::unique_ptr<Filebuffer> readLanguage(const std::string& path) {
+    LineReader reader { path };
+    return std::make_unique<Filebuffer>(reader, [](const Fields& rowslicer) {
+	return rowslicer.size() >= 2 && films.contains(rowslicer[0]);
+    });
+}
 
-    Filebuffer filebuffer { filestream };
-    int size = filebuffer.getBuf().size();
-    Pbar pbar(size/LOGGING_FACTOR);
-    std::mutex mutex {};
+void loadRatings(SQLite::Database& db, Filebuffer& filebuffer) {
+    enum Cols { TCONST, RATING, NUMRATES };
 
-    for (int threadnum = 0; threadnum < THREADLIMIT; ++threadnum) {
-	threadPack.push([&,threadnum](){
-	    SQLite::Statement insert { db, "INSERT INTO Ratings (tconst, rating, numVotes) VALUES (?, ?, ?)" };
-	    int start = filebuffer.getChunksize()*threadnum;
-	    int stop = filebuffer.getChunksize()*(threadnum+1);
-	    for (int line = start; line < std::min(stop,size); ++line) {
-		if (line%LOGGING_FACTOR == 0) {
-		    std::lock_guard<std::mutex> lock { mutex };
-		    pbar.update();
-		}
-		try {
-		    insert.reset(); 
-		    insert.bind(1,filebuffer.getBuf().at(line).at(TCONST).c_str());
-		    insert.bind(2,std::stof(filebuffer.getBuf().at(line).at(RATING).c_str()));
-		    insert.bind(3,std::stoi(filebuffer.getBuf().at(line).at(NUMRATES).c_str()));
-		    insert.exec(); 
-		} catch (SQLite::Exception& e) { 
-		    if (VERBOSE) std::cerr << "Problem inserting ratings: " << e.what() << '\n';
-		} catch (std::exception& e) {
-		    std::cerr << "Error: " << e.what() << '\n';
-		    exit(1);
-		}
-	    }
-	});
-    }
-    threadPack.forEach([&](std::thread& thread) {
-	if (thread.joinable()) {
-	    thread.join();
+    Batch& rows { filebuffer.getBuf() };
+    int size = rows.size();
+    auto progress = reporter.track("ratings", size);
+
+    std::vector<int> order { sortedRows(size, [&](int a, int b) { return idLess(rows.at(a)[TCONST].view(), rows.at(b)[TCONST].view()); }) };
+    BatchInsert<RatingsTable> insert { db, [](const SQLite::Exception& e) {
+	if (VERBOSE) std::cerr << "Problem inserting ratings: " << e.what() << '\n';
+    } };
+    for (int line : order) {
+	progress->add(0);
+	try {
+	    const Fields& row = rows.at(line);
+	    insert.add({ row.at(TCONST).c_str(), std::stof(row.at(RATING).c_str()), std::stoi(row.at(NUMRATES).c_str()) });
+	} catch (std::exception& e) {
+	    std::cerr << "Error: " << e.what() << '\n';
+	    exit(1);
 	}
-    });
+    }
+    insert.flush();
+    progress->finish();
 
     std::cerr << "\nDone reading ratings!" << '\n';
 }
 
-void loadLanguage(SQLite::Database& db, std::ifstream& langfilstream) {
-    /* buffers */
-
+void loadLanguage(SQLite::Database& db, Filebuffer& filebuffer) {
     enum Cols { TCONST, LANG };
 
-    Filebuffer filebuffer { langfilstream };
-    JTB::Vec<std::thread> threadPack {};
-    std::mutex mutex {};
-    int size = filebuffer.getBuf().size();
-
-    for (int threadnum = 0; threadnum < THREADLIMIT; ++threadnum) {
-	int start = filebuffer.getChunksize()*threadnum;
-	int stop = filebuffer.getChunksize()*(threadnum+1);
-	threadPack.push([&,start,stop](){
-	    SQLite::Statement insert { db, "INSERT INTO Languages (tconst, lang) VALUES (?, ?)" };
-	    for (int line = start; line < std::min(stop,size); ++line) {
-		if (filebuffer.getBuf().at(line).size() < 2) continue; 
-		try { 
-		    insert.reset(); 
-		    insert.bind(1,filebuffer.getBuf().at(line).at(TCONST).c_str());
-		    insert.bind(2,filebuffer.getBuf().at(line).at(LANG).c_str());
-		    insert.exec(); 
-		} catch (SQLite::Exception& e) { 
-		    if (VERBOSE) std::cerr << "Problem: " << e.what() << '\n';
-		} catch (std::exception& e) { 
-		    std::cerr << "Error: " << e.what() << '\n';
-		    exit(1);
-		}
-	    }
-	});
-	threadPack.forEach([&](std::thread& thread) {
-	    if (thread.joinable()) {
-		thread.join();
-	    }
-	});
+    Batch& rows { filebuffer.getBuf() };
+    int size = rows.size();
+    auto progress = reporter.track("lang", size);
+
+    std::vector<int> order { sortedRows(size, [&](int a, int b) { return idLess(rows.at(a)[TCONST].view(), rows.at(b)[TCONST].view()); }) };
+    BatchInsert<LanguagesTable> insert { db, [](const SQLite::Exception& e) {
+	if (VERBOSE) std::cerr << "Problem: " << e.what() << '\n';
+    } };
+    for (int line : order) {
+	progress->add(0);
+	if (rows.at(line).size() < 2) continue; 
+	try { 
+	    insert.add({ rows.at(line).at(TCONST).c_str(), rows.at(line).at(LANG).c_str() });
+	} catch (std::exception& e) { 
+	    std::cerr << "Error: " << e.what() << '\n';
+	    exit(1);
+	}
     }
+    insert.flush();
+    progress->finish();
     std::cerr << "Done reading languages!" << '\n';
 };
 
@@ -278,7 +476,8 @@ void reallyTryToFindCannesFilm(const JTB::Str& titleString,
 			       const JTB::Str& director_string,
 			       const SQLite::Database& db,
 			       bool& found,
-			       JTB::Str& tconst){
+			       JTB::Str& tconst,
+			       float& score){
     SQLite::Statement selectAllByDir { db, "SELECT Films.title,Films.tconst FROM Films,Directors,Names WHERE Films.tconst = Directors.tconst \
 	AND Directors.nconst = Names.nconst AND name LIKE ?" };
     selectAllByDir.reset();
@@ -293,15 +492,28 @@ void reallyTryToFindCannesFilm(const JTB::Str& titleString,
 	    best_match.best_tconst = selectAllByDir.getColumn(1).getString();
 	}
     }
+    if (found) {
+	tconst = best_match.best_tconst;
+	score = best_match.match_percent;
+    }
+}
+
+/* cache key for a cannes.tsv title or director: lowercase alphanumeric words, single spaces */
+std::string normalizeForMatch(std::string_view text) {
+    std::string normal {};
+    for (unsigned char c : text) {
+	if (std::isalnum(c)) normal.push_back(static_cast<char>(std::tolower(c)));
+	else if (!normal.empty() && normal.back() != ' ') normal.push_back(' ');
+    }
+    if (!normal.empty() && normal.back() == ' ') normal.pop_back();
+    return normal;
 }
 
-void loadCannes(SQLite::Database& db, std::ifstream& cannesfilestream) {
+void loadCannes(SQLite::Database& db, Filebuffer& filebuffer) {
     enum Cols { TITLE,DIRECTOR,COUNTRIES,LANGUAGES,GENDER,INTERNATIONALCOPRODUCTION,USESVARIOUSLANGUAGES,NOTE };
 
     /* buffers */
-    Filebuffer filebuffer { cannesfilestream };
     JTB::Vec<std::thread> threadPack {};
-    std::mutex mutex {};
     int size = filebuffer.getSize();
     std::regex weakTitleReg { R"(\(?([^\(\)]+)\)?)" };
     std::regex strongTitleReg { R"(\(?([A-Za-z0-9\s]{4,12})\)?)" };
@@ -309,24 +521,52 @@ void loadCannes(SQLite::Database& db, std::ifstream& cannesfilestream) {
     std::regex cutFront { R"((^[^\s]+)|([^A-Za-z0-9]+))" };
     std::regex cutBack { R"((\s[^\s]+$)|([^A-Za-z0-9]+))" };
 
-    Pbar pbar(size/5);
+    auto progress = reporter.track("cannes", size);
+    std::atomic<int> cached {0};
+    std::atomic<int> matched {0};
 
     for (int threadnum = 0; threadnum < THREADLIMIT; ++threadnum) {
-	int start = filebuffer.getChunksize()*threadnum;
-	int stop = filebuffer.getChunksize()*(threadnum+1);
-	threadPack.push([&,start,stop](){
+	int start = filebuffer.chunkStart(threadnum);
+	int stop = filebuffer.chunkStart(threadnum+1);
+	threadPack.push(memtrack::inherit([&,threadnum,start,stop](){
 	    SQLite::Statement select { db, "SELECT Films.tconst FROM Films,Directors,Names WHERE Films.tconst = Directors.tconst \
 		AND Directors.nconst = Names.nconst AND (title LIKE ? OR originalTitle LIKE ?) AND name LIKE ?" };
-	    SQLite::Statement insert { db, "INSERT INTO Cannes (tconst) VALUES (?)" };
+	    SQLite::Statement insert { db, insertSql<CannesTable>() };
+	    SQLite::Statement insert_cached { db, insertSql<CannesTable, 1, OnConflict::IGNORE>() };
+	    SQLite::Statement lookup { db, "SELECT tconst FROM CannesMatchCache WHERE title = ? AND director = ?" };
+	    SQLite::Statement remember { db, insertSql<CannesMatchCacheTable, 1, OnConflict::REPLACE>() };
 	    for (int line = start; line < std::min(stop,size); ++line) {
-		if (line%5 == 0) {
-		    std::lock_guard<std::mutex> lock {mutex};
-		    pbar.update();
-		}
+		progress->add(threadnum);
 		const auto& rowslicer { filebuffer.getBuf().at(line) };
 		if (rowslicer.size() < 7) continue; 
 		try { 
-		    const JTB::Str& titleStringToGrep { rowslicer.at(TITLE) };
+		    std::string title_key { normalizeForMatch(rowslicer.at(TITLE)) };
+		    std::string director_key { normalizeForMatch(rowslicer.at(DIRECTOR)) };
+
+		    /* rows matched (or ruled out) on an earlier run skip the matching entirely */
+		    lookup.tryReset();
+		    lookup.bind(1, title_key);
+		    lookup.bind(2, director_key);
+		    if (lookup.executeStep()) {
+			if (lookup.getColumn(0).isNull()) {
+			    ++cached;
+			    continue;
+			}
+			std::string cached_tconst { lookup.getColumn(0).getString() };
+			lookup.tryReset();
+			insert_cached.tryReset(); 
+			bindRow<CannesTable>(insert_cached, { cached_tconst.c_str() });
+			try {
+			    insert_cached.exec();
+			    ++cached;
+			    continue;
+			} catch (SQLite::Exception& e) {
+			    /* the film it pointed at is gone; match it again */
+			    if (VERBOSE) std::cerr << "Stale Cannes match: " << e.what() << '\n';
+			}
+		    }
+
+		    JTB::Str titleStringToGrep { rowslicer.at(TITLE).c_str() };
 		    /* JTB::Str director_string { std::regex_replace(rowslicer.at(DIRECTOR).c_str(),thingToReplace,R"(%)") };; */
 		    JTB::Str director_string { std::regex_replace(rowslicer.at(DIRECTOR).c_str(),cutFront,R"(%)") };;
 		    /* JTB::Vec<JTB::Str> languages { rowslicer.at(LANGUAGES).split(",") };; */
@@ -338,30 +578,31 @@ void loadCannes(SQLite::Database& db, std::ifstream& cannesfilestream) {
 
 		    bool found = false;
 		    JTB::Str tconst {};
+		    const char* method { "none" };
+		    float score {0};
 
 		    tryToFindCannesFilm(titleStringToGrep,weakTitleReg,thingToReplace,director_string,select,found,tconst);
-
-		    if (found) {
-			insert.reset(); 
-			insert.bind(1,tconst.c_str());
-			insert.exec(); 
-		    }
+		    if (found) { method = "weak"; score = 1; }
 		    else {
 			tryToFindCannesFilm(titleStringToGrep,strongTitleReg,thingToReplace,director_string,select,found,tconst);
-			if (found) {
-			    insert.reset(); 
-			    insert.bind(1,tconst.c_str());
-			    insert.exec(); 
-			}
+			if (found) { method = "strong"; score = 1; }
 			else {
-			    reallyTryToFindCannesFilm(titleStringToGrep,director_string,db,found,tconst);
-			    if (found) {
-				insert.reset(); 
-				insert.bind(1,tconst.c_str());
-				insert.exec(); 
-			    }
+			    reallyTryToFindCannesFilm(titleStringToGrep,director_string,db,found,tconst,score);
+			    if (found) method = "similarity";
 			}
 		    }
+		    ++matched;
+
+		    remember.tryReset();
+		    bindRow<CannesMatchCacheTable>(remember, { title_key.c_str(), director_key.c_str(), 
+			found ? tconst.c_str() : nullptr, method, static_cast<double>(score) });
+		    remember.exec();
+
+		    if (found) {
+			insert.tryReset(); 
+			bindRow<CannesTable>(insert, { tconst.c_str() });
+			insert.exec(); 
+		    }
 
 		} catch (SQLite::Exception& e) { 
 		    if (VERBOSE) std::cerr << "Problem: " << e.what() << '\n';
@@ -370,199 +611,496 @@ void loadCannes(SQLite::Database& db, std::ifstream& cannesfilestream) {
 		    exit(1);
 		}
 	    }
-	});
+	}));
     }
     threadPack.forEach([&](std::thread& thread) {
 	if (thread.joinable()) {
 	    thread.join();
 	}
     });
+    std::cerr << "Cannes: " << cached << " rows from the match cache, " << matched << " matched" << '\n';
+    progress->finish();
     std::cerr << "\nDone with Cannes!" << '\n';
 };
 
-int countlines(std::ifstream& s) {
-    char c {};
-    int count {1};
-    try {
-	while (s.get(c)) {
-	    if (c == '\n') {
-		++count;
-	    }
-	}
-	s.clear();
-	s.seekg(0);
-	return count;
-    } catch (std::exception& e) {
-	std::cerr << "error: " << e.what() << '\n';
-	exit(1);
+/* what a stage has committed so far and which input file it came from. a batched stage
+ * writes one with every batch, in the same transaction as the batch <== 10/19/26 12:20:37 */ 
+struct Checkpoint {
+    std::string file {};
+    long fileSize {0};
+    long fileMtime {0};
+    long byteOffset {0};
+    long rowCount {0};
+    bool complete {false};
+};
+
+/* a missing input throws here, before a stage clears anything for it */
+Checkpoint identify(const std::string& path) {
+    Checkpoint checkpoint { path };
+    std::error_code ec {};
+    checkpoint.fileSize = static_cast<long>(fs::file_size(path, ec));
+    if (ec) throw std::runtime_error("cannot read " + path + ": " + ec.message());
+    auto mtime = fs::last_write_time(path, ec);
+    if (!ec) checkpoint.fileMtime = static_cast<long>(std::chrono::duration_cast<std::chrono::seconds>(
+	std::chrono::file_clock::to_sys(mtime).time_since_epoch()).count());
+    return checkpoint;
+}
+
+bool sameFile(const Checkpoint& a, const Checkpoint& b) {
+    return a.file == b.file && a.fileSize == b.fileSize && a.fileMtime == b.fileMtime;
+}
+
+std::map<std::string, Checkpoint> readCheckpoints(SQLite::Database& db) {
+    std::map<std::string, Checkpoint> checkpoints {};
+    using Col = LoadCheckpointsTable::Col;
+    SQLite::Statement select { db, selectSql<LoadCheckpointsTable>() };
+    while (select.executeStep()) {
+	checkpoints[select.getColumn(Col::STAGE).getString()] = { select.getColumn(Col::FILE).getString(), 
+	    static_cast<long>(select.getColumn(Col::FILESIZE).getInt64()), static_cast<long>(select.getColumn(Col::FILEMTIME).getInt64()),
+	    static_cast<long>(select.getColumn(Col::BYTEOFFSET).getInt64()), static_cast<long>(select.getColumn(Col::ROWCOUNT).getInt64()),
+	    select.getColumn(Col::COMPLETE).getInt() != 0 };
     }
+    return checkpoints;
 }
 
-void loadPrincipals(SQLite::Database& db, std::ifstream& principals_stream, std::ifstream& names_stream) {
-    /* buffers */
-    /* throwing out the first line */
-    JTB::Str buf {};
-    buf.absorbLine(principals_stream).clear();
-    enum class Names { NCONST, NAME };
-    enum class Principles { TCONST, ORDERING, NCONST, CATEGORY, JOB, CHARACTERS };
-
-    Pbar names_pbar(countlines(names_stream)/LOGGING_FACTOR);
-
-    while (names_stream.good()) {
-	std::unique_ptr<JTB::Vec<JTB::Vec<JTB::Str>>> filebuffer {new JTB::Vec<JTB::Vec<JTB::Str>>};
-	int linecount = 0;
-
-	/* pushing into a buffer */
-	while (names_stream.good() && ++linecount < PRINCIPLES_BATCH_SIZE && !buf.clear().absorbLine(names_stream).isEmpty()) {
-	    JTB::Vec<JTB::Str> rowslicer = buf.split("\t");
-	    if (rowslicer.size() < 2) continue;
-	    (*filebuffer).push(rowslicer);
+void saveCheckpoint(SQLite::Database& db, const std::string& stage, const Checkpoint& checkpoint) {
+    SQLite::Statement insert { db, insertSql<LoadCheckpointsTable, 1, OnConflict::REPLACE>() };
+    bindRow<LoadCheckpointsTable>(insert, { stage.c_str(), checkpoint.file.c_str(), checkpoint.fileSize, checkpoint.fileMtime,
+	checkpoint.byteOffset, checkpoint.rowCount, checkpoint.complete ? 1 : 0 });
+    insert.exec();
+}
+
+/* a batched input: the first batch is read ahead of the load. checkpoint holds the file
+ * identity and how far the committed batches got */
+struct BatchedInput {
+    std::unique_ptr<LineReader> reader {};
+    std::function<bool(const Fields&)> keep {};
+    std::string stage {};
+    Checkpoint checkpoint {};
+    std::unique_ptr<Batch> next {};
+};
+
+std::unique_ptr<Batch> readBatch(BatchedInput& input) {
+    std::unique_ptr<Batch> filebuffer {new Batch};
+    std::string_view line {};
+    int linecount = 0;
+
+    /* pushing into a buffer */
+    while (++linecount < PRINCIPLES_BATCH_SIZE && input.reader->next(line)) {
+	if (!line.empty()) filebuffer->push(line, input.keep);
+    }
+    filebuffer->endOffset = input.reader->offset();
+    return filebuffer;
+}
+
+/* starts after the last committed batch when resume is an unfinished checkpoint for the
+ * same file */
+std::unique_ptr<BatchedInput> readBatched(const std::string& stage, const std::string& path, 
+	const Checkpoint& resume, std::function<bool(const Fields&)> keep) {
+    std::unique_ptr<BatchedInput> input {new BatchedInput { nullptr, std::move(keep), stage, identify(path) }};
+    if (sameFile(resume, input->checkpoint) && !resume.complete && resume.byteOffset > 0) {
+	std::cerr << "Resuming " << stage << " at byte " << resume.byteOffset << " (" << resume.rowCount << " rows in)" << '\n';
+	input->checkpoint = resume;
+	input->reader = std::make_unique<LineReader>(path, resume.byteOffset);
+    }
+    else {
+	/* throwing out the first line */
+	input->reader = std::make_unique<LineReader>(path);
+	std::string_view header {};
+	input->reader->next(header);
+	input->checkpoint.byteOffset = input->reader->offset();
+    }
+    input->next = readBatch(*input);
+    return input;
+}
+
+/* hands each batch to insert while the following batch is read in the background. every
+ * batch commits together with its checkpoint, so a restart picks up after the last one,
+ * and progress moves to the byte the batch ended at */
+void forEachBatch(SQLite::Database& db, BatchedInput& input, Progress& progress, std::function<void(std::unique_ptr<Batch>&)> insert) {
+    while (input.next) {
+	std::unique_ptr<Batch> filebuffer { std::move(input.next) };
+	std::future<std::unique_ptr<Batch>> reader {};
+	bool last = input.reader->atEnd();
+	if (!last) {
+	    reader = std::async(std::launch::async, memtrack::inherit(readBatch), std::ref(input));
 	}
+	SQLite::Transaction transaction { db };
+	insert(filebuffer);
+	input.checkpoint.byteOffset = filebuffer->endOffset;
+	input.checkpoint.rowCount += filebuffer->size() + filebuffer->dropped();
+	input.checkpoint.complete = last;
+	saveCheckpoint(db, input.stage, input.checkpoint);
+	transaction.commit();
+	progress.reached(input.checkpoint.byteOffset);
+	if (reader.valid()) input.next = reader.get();
+    }
+}
+
+void loadNames(SQLite::Database& db, BatchedInput& names) {
+    /* measured in bytes of the file, so nothing has to count its lines first */
+    auto progress = reporter.track("names", names.checkpoint.fileSize);
+    progress->add(0, names.checkpoint.rowCount);
+    progress->reached(names.checkpoint.byteOffset);
+    std::string last {};
+
+    forEachBatch(db, names, *progress, [&](std::unique_ptr<Batch>& filebuffer) {
+	progress->add(0, filebuffer->dropped());
+	int size = filebuffer->size();
+	if (size == 0) return;
+	auto nconst = [&](int line) { return filebuffer->at(line)[icast(Names::NCONST)]; };
+	std::vector<int> order { sortedRows(size, [&](int a, int b) { return idLess(nconst(a).view(), nconst(b).view()); }) };
+	checkBatchOrder("names", std::string(nconst(order.front())), last, std::string(nconst(order.back())));
 
 	/* feeding into database <== 12/07/24 11:52:14 */ 
-	JTB::Vec<std::thread> threadPack {};
-	int size = (*filebuffer).size();
-	int chunksize = (*filebuffer).size()/THREADLIMIT;
-	std::mutex mutex {};
-
-	for (int threadnum=0; threadnum < THREADLIMIT; ++threadnum) {
-	    threadPack.push([&,threadnum](){
-		int start = chunksize*(threadnum);
-		int stop = chunksize*(threadnum+1);
-		SQLite::Statement insert { db, "INSERT INTO Names (nconst, name) VALUES (?, ?)" };
-		int min { std::min(stop,size) } ;
-		for (int line = start; line < min; ++line) {
-		    if (line%LOGGING_FACTOR == 0) {
-			std::lock_guard<std::mutex> lock { mutex };
-			names_pbar.update();
-		    }
-		    /* std::cerr << threadnum << " : " << (float(line-start)/chunksize)*100 << '\n'; */
-		    try {
-			insert.reset(); 
-			insert.bind(1,filebuffer->at(line).at(icast(Names::NCONST)).c_str());
-			insert.bind(2,filebuffer->at(line).at(icast(Names::NAME)).c_str());
-			insert.exec(); 
-		    } catch (SQLite::Exception& e) { 
-			if (VERBOSE) std::cerr << "Problem with Names: " << e.what() << '\n';
-		    } catch (std::exception& e) {
-			std::cerr << "Error: " << e.what() << '\n';
-			exit(1);
-		    }
-		}
-	    });
+	BatchInsert<NamesTable, 64, OnConflict::UPDATE> insert { db, [](const SQLite::Exception& e) {
+	    if (VERBOSE) std::cerr << "Problem with Names: " << e.what() << '\n';
+	} };
+	for (int line : order) {
+	    progress->add(0);
+	    try {
+		insert.add({ filebuffer->at(line).at(icast(Names::NCONST)).c_str(), filebuffer->at(line).at(icast(Names::NAME)).c_str() });
+	    } catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << '\n';
+		exit(1);
+	    }
 	}
+	insert.flush();
+    });
+    progress->finish();
+
+    std::cerr << "\nDone reading names!" << '\n';
+}
+
+void loadPrincipals(SQLite::Database& db, BatchedInput& principals) {
+    auto progress = reporter.track("principals", principals.checkpoint.fileSize);
+    progress->add(0, principals.checkpoint.rowCount);
+    progress->reached(principals.checkpoint.byteOffset);
+    std::string last {};
+
+    forEachBatch(db, principals, *progress, [&](std::unique_ptr<Batch>& filebuffer) {
+	/* starting over from the top of the file: the credits loaded before go first, in the
+	 * first batch's transaction, even when that batch kept no rows */
+	if (principals.checkpoint.rowCount == 0) clearTables<DirectorsTable, ActorsTable, WritersTable>(db);
+	progress->add(0, filebuffer->dropped());
+	int size = filebuffer->size();
+	if (size == 0) return;
+	/* tconst order; a film's credits keep their billing order, which the summary's
+	 * credit lists come out in */
+	auto tconst = [&](int line) -> const Field& { return filebuffer->at(line).at(icast(Principles::TCONST)); };
+	auto nconst = [&](int line) -> const Field& { return filebuffer->at(line).at(icast(Principles::NCONST)); };
+	std::vector<int> order { sortedRows(size, [&](int a, int b) { return idLess(tconst(a).view(), tconst(b).view()); }) };
+	checkBatchOrder("principals", std::string(tconst(order.front())), last, std::string(tconst(order.back())));
 
-	for (auto i = 0; i < threadPack.size(); ++i) {
-	    if (threadPack.at(i).joinable()) {
-		threadPack.at(i).join();
+	/* feeding into database <== 12/07/24 11:52:14 */ 
+	BatchInsert<DirectorsTable> directors_insert { db, [](const SQLite::Exception& e) {
+	    if (VERBOSE) std::cerr << "director excpt: " << e.what() << '\n';
+	} };
+	BatchInsert<ActorsTable> actors_insert { db, [](const SQLite::Exception& e) {
+	    if (VERBOSE) std::cerr << "actor excpt: " << e.what() << '\n';
+	} };
+	BatchInsert<WritersTable> writers_insert { db, [](const SQLite::Exception& e) {
+	    if (VERBOSE) std::cerr << "writer excpt: " << e.what() << '\n';
+	} };
+	for (int line : order) {
+	    progress->add(0);
+	    /* batches read before names finished loading haven't been checked against it yet */
+	    if (!people.contains(nconst(line))) continue;
+	    Credit credit = creditOf(filebuffer->at(line).at(icast(Principles::CATEGORY)));
+	    try {
+		/* actors <== 11/29/24 15:39:28 */ 
+		if (credit == Credit::ACTOR) actors_insert.add({ tconst(line).c_str(), nconst(line).c_str() });
+		/* directors <== 11/29/24 15:39:32 */ 
+		else if (credit == Credit::DIRECTOR) directors_insert.add({ tconst(line).c_str(), nconst(line).c_str() });
+		/* writers <== 11/29/24 15:39:37 */ 
+		else if (credit == Credit::WRITER) writers_insert.add({ tconst(line).c_str(), nconst(line).c_str() });
+	    } catch (std::exception& e) {
+		std::cerr << "Error while inserting principals: " << e.what() << '\n';
 	    }
-	};
+	}
+	actors_insert.flush();
+	directors_insert.flush();
+	writers_insert.flush();
+    });
+    progress->finish();
+    std::cerr << "\nDone reading principals!" << '\n';
+}
+
+/* one row per film with everything movies.tsv carries (plus the Cannes flag), built in
+ * a single set-based pass over the loaded tables so list queries don't need the joins */
+void buildFilmSummary(SQLite::Database& db) {
+    SQLite::Transaction transaction { db };
+    db.exec("DROP TABLE IF EXISTS FilmSummary");
+    db.exec(R"(CREATE TABLE "FilmSummary" (
+	tconst TEXT NOT NULL PRIMARY KEY,
+	title TEXT NOT NULL,
+	originalTitle TEXT NOT NULL,
+	year INT,
+	runtimeInMin INT,
+	genres TEXT,
+	rating FLOAT,
+	numVotes INTEGER NOT NULL,
+	lang TEXT,
+	directors TEXT NOT NULL,
+	actors TEXT NOT NULL,
+	writers TEXT NOT NULL,
+	cannes INT NOT NULL,
+	FOREIGN KEY (tconst) REFERENCES Films (tconst)) WITHOUT ROWID)");
+
+    /* the credit lists keep file order and the trailing commas of movies.tsv */
+    auto credits = [](const char* table) {
+	return std::string("SELECT tconst, group_concat(name || ',', '') AS names FROM ")
+	    + "(SELECT c.tconst, Names.name FROM " + table + " c, Names WHERE c.nconst = Names.nconst ORDER BY c.tconst, c.rowid) "
+	    + "GROUP BY tconst";
+    };
+    db.exec(std::string(R"(INSERT INTO FilmSummary
+	WITH g AS (SELECT tconst, group_concat(genre, ',') AS genres FROM (SELECT tconst, genre FROM Genres ORDER BY tconst, rowid) GROUP BY tconst),
+	l AS (SELECT tconst, lang, max(rowid) FROM Languages GROUP BY tconst),
+	y AS (SELECT tconst, min(year) AS year FROM Years GROUP BY tconst),
+	rt AS (SELECT tconst, min(runtimeInMin) AS runtimeInMin FROM Runtimes GROUP BY tconst),
+	d AS ()") + credits("Directors") + R"(),
+	a AS ()" + credits("Actors") + R"(),
+	w AS ()" + credits("Writers") + R"()
+	SELECT Films.tconst, Films.title, Films.originalTitle, y.year, rt.runtimeInMin, g.genres,
+	    Ratings.rating, ifnull(Ratings.numVotes, 0), l.lang, ifnull(d.names, ''), ifnull(a.names, ''), ifnull(w.names, ''),
+	    Cannes.tconst IS NOT NULL
+	FROM Films
+	LEFT JOIN y ON y.tconst = Films.tconst
+	LEFT JOIN rt ON rt.tconst = Films.tconst
+	LEFT JOIN g ON g.tconst = Films.tconst
+	LEFT JOIN Ratings ON Ratings.tconst = Films.tconst
+	LEFT JOIN l ON l.tconst = Films.tconst
+	LEFT JOIN d ON d.tconst = Films.tconst
+	LEFT JOIN a ON a.tconst = Films.tconst
+	LEFT JOIN w ON w.tconst = Films.tconst
+	LEFT JOIN Cannes ON Cannes.tconst = Films.tconst
+	ORDER BY Films.tconst)");
+
+    /* covering indexes for the usual "films by year/rating/votes/language" lists */
+    db.exec("CREATE INDEX FilmSummary_year ON FilmSummary (year, rating, numVotes, title)");
+    db.exec("CREATE INDEX FilmSummary_rating ON FilmSummary (rating, numVotes, year, title)");
+    db.exec("CREATE INDEX FilmSummary_numVotes ON FilmSummary (numVotes, rating, year, title)");
+    db.exec("CREATE INDEX FilmSummary_lang ON FilmSummary (lang, rating, numVotes, year, title)");
+    transaction.commit();
+    db.exec("ANALYZE FilmSummary");
+    std::cerr << "Done building the film summary!" << '\n';
+}
+
+/* writes movies.tsv (the same layout buildMDB produces) straight out of FilmSummary */
+void exportMovies(SQLite::Database& db, const std::string& path) {
+    SQLite::Statement count { db, "SELECT count(*) FROM FilmSummary WHERE numVotes > 0" };
+    count.executeStep();
+    auto progress = reporter.track("export", count.getColumn(0).getInt64());
+
+    SQLite::Statement select { db, R"(SELECT tconst, title, originalTitle, ifnull(year, 'N\a'), ifnull(runtimeInMin, 'N\a'),
+	ifnull(genres, 'N\a'), printf('%.1f', rating), numVotes, ifnull(lang, 'N\a'), directors, actors, writers
+	FROM FilmSummary WHERE numVotes > 0 ORDER BY tconst)" };
+    enum Cols { TCONST, TITLE, ORIGINAL, YEAR, RUNTIME, GENRES, RATING, NUMVOTES, LANG, DIRECTORS, ACTORS, WRITERS };
+
+    /* written beside path and renamed over it at the end, so a failed export leaves the
+     * old file alone */
+    std::string tmppath { path + ".tmp" };
+    std::ofstream os { tmppath, std::ios::binary | std::ios::trunc };
+    if (!os) throw std::runtime_error("cannot open " + tmppath + " for writing");
+    std::string out {};
+    const char tab = '\t';
+    while (select.executeStep()) {
+	out.append(select.getColumn(TCONST).getString()).push_back(tab);
+	out.append(select.getColumn(TITLE).getString()).push_back(';');
+	out.append(select.getColumn(ORIGINAL).getString()).push_back(tab);
+	for (int col : { YEAR, RUNTIME, GENRES, RATING, NUMVOTES, LANG, DIRECTORS, ACTORS }) {
+	    out.append(select.getColumn(col).getString()).push_back(tab);
+	}
+	out.append(select.getColumn(WRITERS).getString()).push_back('\n');
+	progress->add(0);
+	if (out.size() > (1 << 22)) {
+	    os.write(out.data(), out.size());
+	    out.clear();
+	}
     }
+    os.write(out.data(), out.size());
+    os.close();
+    if (!os) {
+	std::error_code ec {};
+	fs::remove(tmppath, ec);
+	throw std::runtime_error("writing " + tmppath + " failed");
+    }
+    fs::rename(tmppath, path);
+    progress->finish();
+    std::cerr << "Done writing " << path << '\n';
+}
 
-    std::cerr << "\nDone reading names!" << '\n';
+/* a stage reads its input with read() as soon as the run starts (or once the stages in
+ * readDeps have read theirs), then runs load() once every stage it depends on has finished
+ * loading. loads run one at a time so that only one stage is ever writing to the database
+ * <== 10/19/26 09:40:11 */ 
+struct Stage {
+    std::string name;
+    JTB::Vec<std::string> deps;
+    JTB::Vec<std::string> readDeps;
+    std::function<void()> read;
+    std::function<void()> load;
+};
 
-    Pbar prin_pbar(countlines(principals_stream)/LOGGING_FACTOR);
+class StageScheduler {
+private:
+    JTB::Vec<Stage> stages {};
+    std::set<std::string> readIn {};
+    std::set<std::string> loaded {};
+    std::mutex mutex {};
+    std::condition_variable cv {};
+    std::mutex writer {};
+public:
+    void add(Stage stage) { stages.push(std::move(stage)); }
+
+    /* in the order they were added, which is dependency order */
+    void forEachStage(std::function<void(const Stage&)> f) {
+	for (auto& stage : stages) f(stage);
+    }
 
-    while (principals_stream.good()) {
-	std::unique_ptr<JTB::Vec<JTB::Vec<JTB::Str>>> filebuffer {new JTB::Vec<JTB::Vec<JTB::Str>>};
-	int linecount = 0;
+    bool has(const std::string& name) {
+	for (auto& stage : stages) if (stage.name == name) return true;
+	return false;
+    }
 
-	/* pushing into a buffer */
-	while (principals_stream.good() && ++linecount < PRINCIPLES_BATCH_SIZE && !buf.clear().absorbLine(principals_stream).isEmpty()) {
-	    JTB::Vec<JTB::Str> rowslicer = buf.split("\t");
-	    if (rowslicer.size() < 6) continue;
-	    (*filebuffer).push(rowslicer);
+    void list(std::ostream& os) {
+	for (auto& stage : stages) {
+	    os << stage.name;
+	    if (stage.deps.size() > 0) os << " (after";
+	    for (auto& dep : stage.deps) os << ' ' << dep;
+	    if (stage.deps.size() > 0) os << ')';
+	    os << '\n';
 	}
+    }
 
-	/* feeding into database <== 12/07/24 11:52:14 */ 
+    /* stages that aren't selected are taken to be in the database already */
+    void run(const std::set<std::string>& selected) {
+	for (auto& stage : stages) {
+	    if (!selected.contains(stage.name)) {
+		readIn.insert(stage.name);
+		loaded.insert(stage.name);
+	    }
+	}
 	JTB::Vec<std::thread> threadPack {};
-	int size = (*filebuffer).size();
-	int chunksize = (*filebuffer).size()/THREADLIMIT;
-	std::mutex mutex {};
-
-	for (int threadnum=0; threadnum < THREADLIMIT; ++threadnum) {
-	    threadPack.push([&,threadnum](){
-		int start = chunksize*(threadnum);
-		int stop = chunksize*(threadnum+1);
-		SQLite::Statement directors_insert { db, "INSERT INTO Directors (tconst, nconst) VALUES (?, ?)" };
-		SQLite::Statement actors_insert { db, "INSERT INTO Actors (tconst, nconst) VALUES (?, ?)" };
-		SQLite::Statement writers_insert { db, "INSERT INTO Writers (tconst, nconst) VALUES (?, ?)" };
-		JTB::Str skipbuf {};
-		int min = std::min(stop,size);
-		for (int line = start; line < min; ++line) {
-		    JTB::Str tconst = filebuffer->at(line).at(icast(Principles::TCONST));
-		    if (line%LOGGING_FACTOR == 0) {
-			std::lock_guard<std::mutex> lock {mutex};
-			prin_pbar.update();
+	for (auto& stage : stages) {
+	    if (!selected.contains(stage.name)) continue;
+	    threadPack.push([&](){
+		/* everything this stage allocates, read and load, is counted under its name */
+		memtrack::Stage scope { stage.name };
+		try {
+		    {
+			std::unique_lock<std::mutex> lock { mutex };
+			cv.wait(lock, [&](){
+			    for (auto& dep : stage.readDeps) if (!readIn.contains(dep)) return false;
+			    return true;
+			});
 		    }
-		    if (tconst == skipbuf) continue;
-		    /* std::cerr << threadnum << " : " << (float(line-start)/chunksize)*100 << '\n'; */
-		    JTB::Str category = filebuffer->at(line).at(icast(Principles::CATEGORY));
-		    try {
-			/* actors <== 11/29/24 15:39:28 */ 
-			if (category.startsWith("a")) {
-			    try {
-				actors_insert.reset();
-				actors_insert.bind(1, tconst.c_str());
-				actors_insert.bind(2, filebuffer->at(line).at(icast(Principles::NCONST)).c_str());
-				actors_insert.exec();
-			    } catch (SQLite::Exception& e) {
-				if (VERBOSE) std::cerr << "actor excpt: " << e.what() << '\n';
-				skipbuf.clear().push(tconst);
-			    } catch (std::exception& e) {
-				std::cerr << "error: " << e.what() << '\n';
-				exit(1);
-			    }
-			}
-			/* directors <== 11/29/24 15:39:32 */ 
-			else if (category.startsWith("d")) {
-			    try {
-				directors_insert.reset();
-				directors_insert.bind(1, tconst.c_str());
-				directors_insert.bind(2, filebuffer->at(line).at(icast(Principles::NCONST)).c_str());
-				directors_insert.exec();
-			    } catch (SQLite::Exception& e) {
-				if (VERBOSE) std::cerr << "director excpt: " << e.what() << '\n';
-				skipbuf.clear().push(tconst);
-			    } catch (std::exception& e) {
-				std::cerr << "error: " << e.what() << '\n';
-				exit(1);
-			    }
-			}
-			/* writers <== 11/29/24 15:39:37 */ 
-			else if (category.startsWith("w")) {
-			    try {
-				writers_insert.reset();
-				writers_insert.bind(1, tconst.c_str());
-				writers_insert.bind(2, filebuffer->at(line).at(icast(Principles::NCONST)).c_str());
-				writers_insert.exec();
-			    } catch (SQLite::Exception& e) {
-				if (VERBOSE) std::cerr << "writer excpt: " << e.what() << '\n';
-				skipbuf.clear().push(tconst);
-			    } catch (std::exception& e) {
-				std::cerr << "error: " << e.what() << '\n';
-				exit(1);
-			    }
-			}
-		    } catch (SQLite::Exception& e) {
-			if (VERBOSE) std::cerr << "Problem with principals: " << e.what() << '\n';
-		    } catch (std::exception& e) {
-			std::cerr << "Error while inserting principals: " << e.what() << '\n';
+		    stage.read();
+		    {
+			std::lock_guard<std::mutex> lock { mutex };
+			readIn.insert(stage.name);
+		    }
+		    cv.notify_all();
+		    {
+			std::unique_lock<std::mutex> lock { mutex };
+			cv.wait(lock, [&](){
+			    for (auto& dep : stage.deps) if (!loaded.contains(dep)) return false;
+			    return true;
+			});
+		    }
+		    {
+			std::lock_guard<std::mutex> lock { writer };
+			stage.load();
+		    }
+		    {
+			std::lock_guard<std::mutex> lock { mutex };
+			loaded.insert(stage.name);
 		    }
+		    cv.notify_all();
+		} catch (std::exception& e) {
+		    std::cerr << "Error in stage " << stage.name << ": " << e.what() << '\n';
+		    exit(1);
 		}
 	    });
 	}
+	threadPack.forEach([&](std::thread& thread) {
+	    if (thread.joinable()) {
+		thread.join();
+	    }
+	});
+    }
+};
+
+#ifdef BMDB_MEMTRACK
+/* sqlite allocates with malloc, so none of this shows up in the memtrack stages */
+void reportSqliteMemory(SQLite::Database& db) {
+    sqlite3_int64 current {0};
+    sqlite3_int64 highwater {0};
+    sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &current, &highwater, 0);
+    std::cerr << "sqlite memoryUsed=" << current << " peak=" << highwater;
+    sqlite3_status64(SQLITE_STATUS_PAGECACHE_OVERFLOW, &current, &highwater, 0);
+    std::cerr << " pagecacheOverflow=" << current << " pagecachePeak=" << highwater;
+    sqlite3_status64(SQLITE_STATUS_MALLOC_SIZE, &current, &highwater, 0);
+    std::cerr << " largestMalloc=" << highwater;
+    sqlite3_status64(SQLITE_STATUS_MALLOC_COUNT, &current, &highwater, 0);
+    std::cerr << " mallocs=" << current << " mallocsPeak=" << highwater;
+    int cacheUsed {0};
+    int unused {0};
+    sqlite3_db_status(db.getHandle(), SQLITE_DBSTATUS_CACHE_USED, &cacheUsed, &unused, 0);
+    std::cerr << " cacheUsed=" << cacheUsed << '\n';
+}
+#endif
 
-	for (auto i = 0; i < threadPack.size(); ++i) {
-	    if (threadPack.at(i).joinable()) {
-		threadPack.at(i).join();
+/* answers one query straight off the TSV dumps (no import), printing TSV with a header
+ * row. the dumps show up as basics, ratings, principals and names <== 10/19/26 13:40:52 */
+int runQuery(const std::map<std::string, std::string>& inputs, const std::string& sql) {
+    try {
+	SQLite::Database db { ":memory:", SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE };
+	if (registerTsvModule(db.getHandle()) != SQLITE_OK) {
+	    std::cerr << "Could not register the imdbtsv module" << '\n';
+	    return 1;
+	}
+	for (auto& table : { "basics", "ratings", "principals", "names" }) {
+	    std::string path { inputs.at(table) };
+	    if (!fs::exists(path)) continue;
+	    std::string quoted {};
+	    for (auto c : path) quoted += c == '\'' ? std::string("''") : std::string(1, c);
+	    db.exec(std::string("CREATE VIRTUAL TABLE ") + table + " USING imdbtsv('" + quoted + "')");
+	}
+	SQLite::Statement query { db, sql };
+	int columns = query.getColumnCount();
+	for (int i = 0; i < columns; ++i) std::cout << (i > 0 ? "\t" : "") << query.getColumnName(i);
+	std::cout << '\n';
+	while (query.executeStep()) {
+	    for (int i = 0; i < columns; ++i) {
+		auto column = query.getColumn(i);
+		std::cout << (i > 0 ? "\t" : "") << (column.isNull() ? std::string(R"(\N)") : column.getString());
 	    }
-	};
+	    std::cout << '\n';
+	}
+    } catch (SQLite::Exception& e) {
+	std::cerr << "Query failed: " << e.what() << '\n';
+	return 1;
     }
-    std::cerr << "\nDone reading principals!" << '\n';
+    return 0;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+
+    /* stages to run come from the command line; no stages means the whole build */
+    std::set<std::string> selected {};
+    bool listOnly = false;
+    bool fresh = false;
+    std::string query {};
+    for (int i = 1; i < argc; ++i) {
+	std::string arg { argv[i] };
+	if (arg == "--list") listOnly = true;
+	/* --query "SQL" runs against the raw dumps and exits */
+	else if (arg == "--query" && i+1 < argc) query = argv[++i];
+	/* ignore (and drop) the checkpoints of the stages being run */
+	else if (arg == "--fresh") fresh = true;
+	else selected.insert(arg);
+    }
 
     /* reading the directory and opening the relevant files if they're found */
     auto environ = std::getenv("__MOVIE_DATABASE_PATH");
@@ -576,6 +1114,18 @@ int main() {
 	std::cout << movieDatabasePath.str() << '\n';
     }
 
+    /* the input file behind each loading stage */
+    std::map<std::string, std::string> inputs {
+	{ "lang", movieDatabasePath.str() + "/lang.tsv" },
+	{ "cannes", movieDatabasePath.str() + "/cannes.tsv" },
+	{ "basics", movieDatabasePath.str() + "/title.basics.tsv" },
+	{ "ratings", movieDatabasePath.str() + "/title.ratings.tsv" },
+	{ "principals", movieDatabasePath.str() + "/title.principals.tsv" },
+	{ "names", movieDatabasePath.str() + "/name.basics.tsv" },
+    };
+
+    if (!query.empty()) return runQuery(inputs, query);
+
     environ = std::getenv("MOVIES");
     std::stringstream moviesWithPath { "" }; 
     moviesWithPath << (environ == nullptr ? "" : environ);
@@ -587,25 +1137,6 @@ int main() {
 	std::cout << moviesWithPath.str() << '\n';
     }
 
-    std::ifstream lang_stream {};
-    std::ifstream cannes_stream {};
-    std::ifstream basics_stream {}; 
-    std::ifstream ratings_stream {}; 
-    std::ifstream principals_stream {};
-    std::ifstream name_basics_stream {};
-    try { 
-	lang_stream.open( movieDatabasePath.str() + "/lang.tsv" );
-	cannes_stream.open( movieDatabasePath.str() + "/cannes.tsv" );
-	basics_stream.open( movieDatabasePath.str() + "/title.basics.tsv" ); 
-	ratings_stream.open( movieDatabasePath.str() + "/title.ratings.tsv" ); 
-	principals_stream.open( movieDatabasePath.str() + "/title.principals.tsv" );
-	name_basics_stream.open( movieDatabasePath.str() + "/name.basics.tsv" );
-    } catch (std::exception& e) { 
-	std::cerr << "Problem with opening filestreams" << '\n';
-	std::cerr << "Error: " << e.what() << '\n';
-	exit(1);
-    }
-
     try {
 	SQLite::Database db {movieDatabasePath.str() + "/moviedatabase.db", SQLite::OPEN_READWRITE|SQLite::OPEN_CREATE};
 	SQLite::Statement wal { db, "pragma journal_mode = WAL" };
@@ -621,70 +1152,181 @@ int main() {
 	wal.executeStep(); 
 	/* sync.executeStep(); */ 
 	tempstore.executeStep(); mmap.executeStep();
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Films" (
-	    tconst TEXT NOT NULL PRIMARY KEY,
-	    title TEXT NOT NULL,
-	    originalTitle TEXT NOT NULL))");
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Genres" (
-	    tconst TEXT NOT NULL,
-	    genre TEXT NOT NULL,
-	    FOREIGN KEY (tconst) REFERENCES Films (tconst)))");
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Runtimes" (
-	    tconst TEXT NOT NULL, 
-	    runtimeInMin INT NOT NULL,
-	    FOREIGN KEY (tconst) REFERENCES Films (tconst),
-	    UNIQUE(tconst, runtimeInMin)))");
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Years" (
-	    tconst TEXT NOT NULL,
-	    year INT NOT NULL,
-	    FOREIGN KEY (tconst) REFERENCES Films (tconst),
-	    UNIQUE(tconst, year)))");
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Names" (
-	    nconst TEXT NOT NULL PRIMARY KEY,
-	    name TEXT NOT NULL,
-	    UNIQUE(nconst, name)))");
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Directors" (
-	    tconst TEXT NOT NULL, 
-	    nconst TEXT NOT NULL, 
-	    FOREIGN KEY (tconst) REFERENCES Films (tconst),
-	    FOREIGN KEY (nconst) REFERENCES Names (nconst),
-	    UNIQUE(tconst,nconst)))");
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Actors" (
-	    tconst TEXT NOT NULL, 
-	    nconst TEXT NOT NULL, 
-	    FOREIGN KEY (tconst) REFERENCES Films (tconst),
-	    FOREIGN KEY (nconst) REFERENCES Names (nconst),
-	    UNIQUE(tconst,nconst)))");
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Writers" (
-	    tconst TEXT NOT NULL, 
-	    nconst TEXT NOT NULL, 
-	    FOREIGN KEY (tconst) REFERENCES Films (tconst),
-	    FOREIGN KEY (nconst) REFERENCES Names (nconst),
-	    UNIQUE(tconst,nconst)))");
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Cannes" (
-	    tconst TEXT NOT NULL UNIQUE, 
-	    FOREIGN KEY (tconst) REFERENCES Films (tconst)))");
+	/* pragmas that return a row stay "in progress" until reset, which blocks COMMIT */
+	wal.reset(); cache.reset(); locking.reset(); tempstore.reset(); mmap.reset(); foreign_keys.reset();
 	/* db.exec(R"(CREATE TABLE IF NOT EXISTS "KnownFor" ( */
 	/*     tconst TEXT NOT NULL, */ 
 	/*     nconst TEXT NOT NULL, */ 
 	/*     FOREIGN KEY (tconst) REFERENCES Films (tconst), */
 	/*     FOREIGN KEY (nconst) REFERENCES Names (nconst), */
 	/*     UNIQUE(tconst,nconst)))"); */
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Ratings" (
-	    tconst TEXT NOT NULL UNIQUE, 
-	    rating FLOAT NOT NULL,
-	    numVotes INTEGER NOT NULL,
-	    FOREIGN KEY (tconst) REFERENCES Films (tconst)))");
-	db.exec(R"(CREATE TABLE IF NOT EXISTS "Languages" (
-	    tconst TEXT NOT NULL, 
-	    lang TEXT NOT NULL,
-	    FOREIGN KEY (tconst) REFERENCES Films (tconst)))");
-
-	/* loadBasics(db, basics_stream); */
-	/* loadRatings(db, ratings_stream); */
-	/* loadLanguage(db, lang_stream); */
-	/* loadPrincipals(db, principals_stream, name_basics_stream); */
-	loadCannes(db, cannes_stream);
+	/* the columns live in tables.h */
+	createTables<FilmsTable, GenresTable, RuntimesTable, YearsTable, NamesTable, DirectorsTable, ActorsTable, WritersTable,
+	    CannesTable, RatingsTable, LanguagesTable, CannesMatchCacheTable, LoadCheckpointsTable>(db);
+
+	std::map<std::string, Checkpoint> checkpoints { readCheckpoints(db) };
+	auto resumeFrom = [&](const std::string& stage) {
+	    auto found = checkpoints.find(stage);
+	    return found == checkpoints.end() ? Checkpoint {} : found->second;
+	};
+
+	/* a whole-file stage commits in one transaction together with its checkpoint. it
+	 * always loads from the top, so clear first empties the rows it loaded last time */
+	auto committed = [&](const std::string& stage, std::function<void()> clear, std::function<long()> load) {
+	    return [&, stage, clear, load](){
+		Checkpoint checkpoint { identify(inputs.at(stage)) };
+		SQLite::Transaction transaction { db };
+		clear();
+		checkpoint.rowCount = load();
+		checkpoint.byteOffset = checkpoint.fileSize;
+		checkpoint.complete = true;
+		saveCheckpoint(db, stage, checkpoint);
+		transaction.commit();
+	    };
+	};
+
+	/* as a stage starts reading, the kernel is asked for the front of the next file in
+	 * the usual read order (basics and names start together, then the rest) */
+	const std::vector<std::string> readOrder { "basics", "names", "ratings", "lang", "principals", "cannes" };
+	std::mutex hinting {};
+	std::set<std::string> hinted {};
+	auto upNext = [&](const std::string& stage) {
+	    std::lock_guard<std::mutex> lock { hinting };
+	    hinted.insert(stage);
+	    auto at = std::find(readOrder.begin(), readOrder.end(), stage);
+	    for (++at; at != readOrder.end(); ++at) {
+		if (!selected.contains(*at) || hinted.contains(*at)) continue;
+		hinted.insert(*at);
+		LineReader::prefetch(inputs.at(*at));
+		return;
+	    }
+	};
+
+	/* the stage DAG: each stage waits on the tables its foreign keys point at */
+	std::unique_ptr<Filebuffer> basics {};
+	std::unique_ptr<Filebuffer> ratings {};
+	std::unique_ptr<Filebuffer> langs {};
+	std::unique_ptr<Filebuffer> cannes {};
+	std::unique_ptr<BatchedInput> names {};
+	std::unique_ptr<BatchedInput> principals {};
+	StageScheduler scheduler {};
+	scheduler.add({ "basics", {}, {}, 
+	    [&](){ upNext("basics"); basics = readBasics(inputs.at("basics")); },
+	    committed("basics", [&](){ clearTables<GenresTable, RuntimesTable, YearsTable>(db); }, [&](){ 
+		loadBasics(db, *basics);
+		long rows = basics->getSize() + basics->getDropped();
+		basics.reset();
+		return rows;
+	    }) });
+	scheduler.add({ "ratings", { "basics" }, { "basics" }, 
+	    [&](){ upNext("ratings"); ratings = readRatings(inputs.at("ratings")); },
+	    committed("ratings", [&](){ clearTables<RatingsTable>(db); }, [&](){
+		loadRatings(db, *ratings);
+		long rows = ratings->getSize() + ratings->getDropped();
+		ratings.reset();
+		return rows;
+	    }) });
+	scheduler.add({ "lang", { "basics" }, { "basics" }, 
+	    [&](){ upNext("lang"); langs = readLanguage(inputs.at("lang")); },
+	    committed("lang", [&](){ clearTables<LanguagesTable>(db); }, [&](){
+		loadLanguage(db, *langs);
+		long rows = langs->getSize() + langs->getDropped();
+		langs.reset();
+		return rows;
+	    }) });
+	scheduler.add({ "names", {}, {}, 
+	    [&](){ upNext("names"); names = readBatched("names", inputs.at("names"), resumeFrom("names"), [](const Fields& rowslicer) {
+		if (rowslicer.size() < 2) return false;
+		people.insert(rowslicer[icast(Names::NCONST)]);
+		return true;
+	    }); },
+	    [&](){ loadNames(db, *names); names.reset(); } });
+	scheduler.add({ "principals", { "basics", "names" }, { "basics" }, 
+	    [&](){ upNext("principals"); principals = readBatched("principals", inputs.at("principals"), resumeFrom("principals"), [](const Fields& rowslicer) {
+		return rowslicer.size() >= 6
+		    && films.contains(rowslicer[icast(Principles::TCONST)])
+		    && creditOf(rowslicer[icast(Principles::CATEGORY)]) != Credit::NONE;
+	    }); },
+	    [&](){ loadPrincipals(db, *principals); principals.reset(); } });
+	scheduler.add({ "cannes", { "basics", "names", "principals" }, {}, 
+	    [&](){ 
+		upNext("cannes");
+		LineReader reader { inputs.at("cannes") };
+		cannes = std::make_unique<Filebuffer>(reader);
+	    },
+	    committed("cannes", [&](){ clearTables<CannesTable>(db); }, [&](){
+		loadCannes(db, *cannes);
+		long rows = cannes->getSize();
+		cannes.reset();
+		return rows;
+	    }) });
+	scheduler.add({ "summary", { "basics", "ratings", "lang", "names", "principals", "cannes" }, {}, 
+	    [](){},
+	    [&](){ buildFilmSummary(db); } });
+	scheduler.add({ "export", { "summary" }, {}, 
+	    [](){},
+	    [&](){ exportMovies(db, moviesWithPath.str()); } });
+
+	if (selected.empty()) {
+	    /* export overwrites $MOVIES, so it only runs when asked for */
+	    for (auto stage : { "basics", "ratings", "lang", "names", "principals", "cannes", "summary" }) selected.insert(stage);
+	}
+	for (auto& stage : selected) {
+	    if (!scheduler.has(stage)) {
+		std::cerr << "Unknown stage: " << stage << ". Stages are:" << '\n';
+		scheduler.list(std::cerr);
+		exit(1);
+	    }
+	}
+	if (listOnly) {
+	    scheduler.list(std::cout);
+	    return 0;
+	}
+	/* stages whose input is unchanged and fully committed are skipped, unless something
+	 * they depend on is being reloaded in this run. others with a partial checkpoint resume */
+	if (fresh) {
+	    for (auto& stage : selected) {
+		SQLite::Statement forget { db, "DELETE FROM LoadCheckpoints WHERE stage = ?" };
+		forget.bind(1, stage);
+		forget.exec();
+		checkpoints.erase(stage);
+	    }
+	}
+	scheduler.forEachStage([&](const Stage& stage) {
+	    if (!selected.contains(stage.name) || !inputs.contains(stage.name) || !checkpoints.contains(stage.name)) return;
+	    const Checkpoint& checkpoint { checkpoints[stage.name] };
+	    if (!checkpoint.complete || !sameFile(checkpoint, identify(inputs[stage.name]))) return;
+	    for (auto& dep : stage.deps) if (selected.contains(dep)) return;
+	    std::cerr << "Skipping " << stage.name << ": already loaded from " << checkpoint.file << " (--fresh reloads it)" << '\n';
+	    selected.erase(stage.name);
+	});
+	/* what's left resumes only from a partial checkpoint, and only if nothing it depends on
+	 * is reloaded; a finished one, or one whose films or names are about to change, starts
+	 * again from the top (and clears what it loaded before) */
+	scheduler.forEachStage([&](const Stage& stage) {
+	    if (!selected.contains(stage.name) || !checkpoints.contains(stage.name)) return;
+	    bool restart = checkpoints[stage.name].complete;
+	    for (auto& dep : stage.deps) if (selected.contains(dep)) restart = true;
+	    if (restart) checkpoints.erase(stage.name);
+	});
+
+	/* "no match" may not hold once films, names or credits are reloaded */
+	if (selected.contains("basics") || selected.contains("names") || selected.contains("principals")) {
+	    db.exec("DELETE FROM CannesMatchCache WHERE tconst IS NULL");
+	}
+
+	/* stages that filter on films/people but run without (all of) the stage that fills them */
+	bool namesResume = checkpoints.contains("names") && !checkpoints["names"].complete && checkpoints["names"].byteOffset > 0;
+	if (!selected.contains("basics")) films.loadFrom(db, "SELECT tconst FROM Films");
+	if ((!selected.contains("names") || namesResume) && selected.contains("principals")) people.loadFrom(db, "SELECT nconst FROM Names");
+
+	reporter.start();
+	scheduler.run(selected);
+	reporter.stop();
+#ifdef BMDB_MEMTRACK
+	reportSqliteMemory(db);
+	memtrack::report(std::cerr);
+#endif
     } catch (std::exception& e) {
 	std::cerr << "error at the start: " << e.what() << '\n';
 	exit(1);
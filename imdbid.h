@@ -0,0 +1,20 @@
+#pragma once
+#include <string_view>
+
+/* "tt0123456" -> 123456; -1 for anything that isn't two letters and digits. the ids'
+ * numbers are what IdSet keeps and what the .idx sidecars are sorted on */
+inline long idNumber(std::string_view id) {
+    if (id.size() < 3) return -1;
+    long n {0};
+    for (auto c : id.substr(2)) {
+	if (c < '0' || c > '9') return -1;
+	n = n*10 + (c - '0');
+    }
+    return n;
+}
+
+/* the dumps' own order: by number, which for ids with the same prefix is shorter first
+ * and then byte by byte ("tt9999999" before "tt10000000", unlike memcmp) */
+inline bool idLess(std::string_view a, std::string_view b) {
+    return a.size() != b.size() ? a.size() < b.size() : a < b;
+}
@@ -0,0 +1,190 @@
+#pragma once
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+#include <array>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/* reads a file line by line while a read-ahead thread fills the next block, so parsing
+ * one block never waits on the disk for the next. two blocks trade places: the reader
+ * thread fills one with pread while the other is handed out as lines, and it keeps
+ * asking the kernel (posix_fadvise WILLNEED) for the range after the one it's reading.
+ * offset() is the byte just past the last line handed out, which is what a checkpoint
+ * needs to resume from, and against size() it's how far through the file a stage is.
+ * a read that fails throws from next() rather than passing for the end of the file
+ * <== 10/19/26 16:10:05 */
+class LineReader {
+private:
+    static constexpr size_t BLOCK_SIZE = 1 << 22;
+    struct Block {
+	std::unique_ptr<char[]> data {};
+	size_t size {0};
+	long offset {0};
+	bool filled {false};
+	bool last {false};
+	int error {0};
+    };
+    std::string path {};
+    int fd {-1};
+    long fileSize {0};
+    long startOffset {0};
+    std::array<Block, 2> blocks {};
+    std::mutex mutex {};
+    std::condition_variable cv {};
+    std::thread readahead {};
+    bool stopping {false};
+
+    /* the consumer's side */
+    int current {0};
+    size_t pos {0};
+    bool haveBlock {false};
+    bool ended {false};
+    std::string carry {};
+    bool carried {false};
+    std::string failure {};
+
+    void readAhead(long offset) {
+	int slot = 0;
+	while (true) {
+	    Block& block = blocks[slot];
+	    {
+		std::unique_lock<std::mutex> lock { mutex };
+		cv.wait(lock, [&](){ return stopping || !block.filled; });
+		if (stopping) return;
+	    }
+	    posix_fadvise(fd, offset + BLOCK_SIZE, BLOCK_SIZE * 2, POSIX_FADV_WILLNEED);
+	    size_t got = 0;
+	    int error = 0;
+	    while (got < BLOCK_SIZE) {
+		ssize_t n = pread(fd, block.data.get() + got, BLOCK_SIZE - got, offset + got);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0) error = errno;
+		if (n <= 0) break;
+		got += static_cast<size_t>(n);
+	    }
+	    {
+		std::lock_guard<std::mutex> lock { mutex };
+		block.size = got;
+		block.offset = offset;
+		block.last = got < BLOCK_SIZE;
+		block.error = error;
+		block.filled = true;
+	    }
+	    cv.notify_all();
+	    if (block.last) return;
+	    offset += static_cast<long>(got);
+	    slot = 1 - slot;
+	}
+    }
+
+    /* hands the finished block back to the reader thread and waits for the next one. a
+     * block the reader thread couldn't read throws, here and on every call after */
+    bool nextBlock() {
+	if (!failure.empty()) throw std::runtime_error(failure);
+	std::unique_lock<std::mutex> lock { mutex };
+	if (haveBlock) {
+	    if (blocks[current].last) return false;
+	    blocks[current].filled = false;
+	    current = 1 - current;
+	    cv.notify_all();
+	}
+	cv.wait(lock, [&](){ return blocks[current].filled; });
+	if (blocks[current].error != 0) {
+	    failure = "cannot read " + path + ": " + std::strerror(blocks[current].error);
+	    throw std::runtime_error(failure);
+	}
+	haveBlock = true;
+	pos = 0;
+	return true;
+    }
+public:
+    /* a file that can't be opened throws: read as empty, it would load (and checkpoint)
+     * a stage with nothing in it */
+    explicit LineReader(const std::string& path, long offset = 0): path(path), startOffset(offset) {
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+	struct stat st {};
+	fstat(fd, &st);
+	fileSize = static_cast<long>(st.st_size);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	for (auto& block : blocks) block.data.reset(new char[BLOCK_SIZE]);
+	readahead = std::thread(&LineReader::readAhead, this, offset);
+    }
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+    ~LineReader() {
+	{
+	    std::lock_guard<std::mutex> lock { mutex };
+	    stopping = true;
+	}
+	cv.notify_all();
+	if (readahead.joinable()) readahead.join();
+	if (fd >= 0) ::close(fd);
+    }
+
+    /* the line (without its newline) stays valid until the next call */
+    bool next(std::string_view& line) {
+	if (carried) {
+	    carry.clear();
+	    carried = false;
+	}
+	while (!ended) {
+	    if (!haveBlock || pos >= blocks[current].size) {
+		if (!nextBlock()) {
+		    ended = true;
+		    /* a last line with no newline after it */
+		    if (carry.empty()) return false;
+		    line = carry;
+		    carried = true;
+		    return true;
+		}
+		continue;
+	    }
+	    const Block& block = blocks[current];
+	    const char* start = block.data.get() + pos;
+	    const char* newline = static_cast<const char*>(std::memchr(start, '\n', block.size - pos));
+	    if (newline == nullptr) {
+		carry.append(start, block.size - pos);
+		pos = block.size;
+		continue;
+	    }
+	    size_t length = static_cast<size_t>(newline - start);
+	    pos += length + 1;
+	    if (carry.empty()) {
+		line = { start, length };
+	    }
+	    else {
+		carry.append(start, length);
+		line = carry;
+		carried = true;
+	    }
+	    return true;
+	}
+	return false;
+    }
+
+    long offset() const {
+	if (ended) return fileSize;
+	return haveBlock ? blocks[current].offset + static_cast<long>(pos) : startOffset;
+    }
+
+    bool atEnd() const { return ended || offset() >= fileSize; }
+
+    long size() const { return fileSize; }
+
+    /* starts the kernel reading the front of a file that's about to be needed */
+    static void prefetch(const std::string& path) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return;
+	posix_fadvise(fd, 0, BLOCK_SIZE * 4, POSIX_FADV_WILLNEED);
+	::close(fd);
+    }
+};
@@ -0,0 +1,196 @@
+#pragma once
+#include <string_view>
+#include <ostream>
+#include <utility>
+
+/* allocation tracking, compiled in with -DBMDB_MEMTRACK (make bmdbsql-memtrack). every
+ * operator new is counted against the stage that was current on the allocating thread,
+ * and the frees go back to the same stage, so each stage gets its allocation count,
+ * bytes, and peak live bytes. memtrack::Stage marks a stage on the current thread and
+ * memtrack::inherit carries it into threads spawned from there. without the flag these
+ * are no-ops and new/delete are left alone <== 10/19/26 15:04:12
+ *
+ * the replacement operators are defined here, not inline (the standard doesn't allow it),
+ * so this has to be included by exactly one translation unit, the one main is in */
+
+#ifdef BMDB_MEMTRACK
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <sys/resource.h>
+
+namespace memtrack {
+
+    struct StageStats {
+	char name[32] {};
+	std::atomic<long> allocs {0};
+	std::atomic<long> frees {0};
+	std::atomic<long> bytes {0};
+	std::atomic<long> live {0};
+	std::atomic<long> peak {0};
+    };
+
+    /* slot 0 is everything outside a stage */
+    inline constexpr int MAX_STAGES = 32;
+    inline StageStats stages[MAX_STAGES] {};
+    inline std::atomic<int> stageCount {1};
+    inline std::mutex registering {};
+    inline StageStats total {};
+    inline thread_local int current {0};
+
+    /* 16 bytes so the block handed back stays 16-aligned */
+    struct Header {
+	uint64_t size;
+	uint32_t stage;
+	uint32_t offset;
+    };
+    static_assert(sizeof(Header) == 16);
+
+    inline void raise(std::atomic<long>& peak, long value) {
+	long seen = peak.load(std::memory_order_relaxed);
+	while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+
+    inline void counted(StageStats& stats, long size) {
+	stats.allocs.fetch_add(1, std::memory_order_relaxed);
+	stats.bytes.fetch_add(size, std::memory_order_relaxed);
+	raise(stats.peak, stats.live.fetch_add(size, std::memory_order_relaxed) + size);
+    }
+
+    inline void uncounted(StageStats& stats, long size) {
+	stats.frees.fetch_add(1, std::memory_order_relaxed);
+	stats.live.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    inline void* allocate(std::size_t size, std::size_t align) {
+	std::size_t offset = align > sizeof(Header) ? align : sizeof(Header);
+	std::size_t length = size + offset;
+	void* base = offset > sizeof(Header)
+	    ? std::aligned_alloc(offset, (length + offset - 1) / offset * offset)
+	    : std::malloc(length);
+	if (base == nullptr) return nullptr;
+	char* block = static_cast<char*>(base) + offset;
+	Header* header = reinterpret_cast<Header*>(block) - 1;
+	header->size = size;
+	header->stage = static_cast<uint32_t>(current);
+	header->offset = static_cast<uint32_t>(offset);
+	counted(stages[current], static_cast<long>(size));
+	counted(total, static_cast<long>(size));
+	return block;
+    }
+
+    inline void release(void* block) {
+	if (block == nullptr) return;
+	Header* header = static_cast<Header*>(block) - 1;
+	uncounted(stages[header->stage], static_cast<long>(header->size));
+	uncounted(total, static_cast<long>(header->size));
+	std::free(static_cast<char*>(block) - header->offset);
+    }
+
+    inline int indexOf(std::string_view name) {
+	std::lock_guard<std::mutex> lock { registering };
+	int count = stageCount.load();
+	for (int i = 1; i < count; ++i) {
+	    if (name == stages[i].name) return i;
+	}
+	if (count == MAX_STAGES) return 0;
+	std::size_t length = std::min(name.size(), sizeof(stages[count].name) - 1);
+	std::memcpy(stages[count].name, name.data(), length);
+	stageCount.store(count + 1);
+	return count;
+    }
+
+    class Stage {
+    private:
+	int previous;
+    public:
+	explicit Stage(std::string_view name): previous(current) { current = indexOf(name); }
+	Stage(const Stage&) = delete;
+	Stage& operator=(const Stage&) = delete;
+	~Stage() { current = previous; }
+    };
+
+    /* wraps f so it runs under the stage that's current here, on whichever thread */
+    template <typename F>
+    auto inherit(F f) {
+	return [stage = current, f = std::move(f)](auto&&... args) mutable {
+	    current = stage;
+	    return f(std::forward<decltype(args)>(args)...);
+	};
+    }
+
+    inline void report(std::ostream& os) {
+	auto line = [&](const char* name, const StageStats& stats) {
+	    os << "memory stage=" << name << " allocs=" << stats.allocs.load() << " bytes=" << stats.bytes.load()
+		<< " peak=" << stats.peak.load() << " live=" << stats.live.load() << '\n';
+	};
+	line("(none)", stages[0]);
+	for (int i = 1; i < stageCount.load(); ++i) line(stages[i].name, stages[i]);
+	line("(all)", total);
+	struct rusage usage {};
+	getrusage(RUSAGE_SELF, &usage);
+	os << "memory maxrss=" << usage.ru_maxrss * 1024L << '\n';
+    }
+}
+
+void* operator new(std::size_t size) {
+    void* block = memtrack::allocate(size, 0);
+    if (block == nullptr) throw std::bad_alloc();
+    return block;
+}
+void* operator new[](std::size_t size) {
+    void* block = memtrack::allocate(size, 0);
+    if (block == nullptr) throw std::bad_alloc();
+    return block;
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return memtrack::allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return memtrack::allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t align) {
+    void* block = memtrack::allocate(size, static_cast<std::size_t>(align));
+    if (block == nullptr) throw std::bad_alloc();
+    return block;
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+    void* block = memtrack::allocate(size, static_cast<std::size_t>(align));
+    if (block == nullptr) throw std::bad_alloc();
+    return block;
+}
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return memtrack::allocate(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return memtrack::allocate(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* block) noexcept { memtrack::release(block); }
+void operator delete[](void* block) noexcept { memtrack::release(block); }
+void operator delete(void* block, std::size_t) noexcept { memtrack::release(block); }
+void operator delete[](void* block, std::size_t) noexcept { memtrack::release(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { memtrack::release(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { memtrack::release(block); }
+void operator delete(void* block, std::align_val_t) noexcept { memtrack::release(block); }
+void operator delete[](void* block, std::align_val_t) noexcept { memtrack::release(block); }
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept { memtrack::release(block); }
+void operator delete[](void* block, std::size_t, std::align_val_t) noexcept { memtrack::release(block); }
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept { memtrack::release(block); }
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept { memtrack::release(block); }
+
+#else
+
+namespace memtrack {
+    class Stage {
+    public:
+	explicit Stage(std::string_view) {}
+    };
+
+    template <typename F>
+    F inherit(F f) { return f; }
+
+    inline void report(std::ostream&) {}
+}
+
+#endif
@@ -0,0 +1,145 @@
+#pragma once
+#include <cstring>
+#include <cstdint>
+#include <string_view>
+#include <memory>
+#include <vector>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include <new>
+
+/* one field of a parsed row: a view into a RowArena, always null-terminated so it
+ * can go straight to sqlite as a c string */
+class Field {
+private:
+    const char* ptr { "" };
+    uint32_t len {0};
+public:
+    Field() {};
+    Field(const char* ptr, uint32_t len): ptr(ptr), len(len) {};
+    const char* c_str() const { return ptr; }
+    std::string_view view() const { return { ptr, len }; }
+    operator std::string_view() const { return view(); }
+    int size() const { return static_cast<int>(len); }
+    bool isEmpty() const { return len == 0; }
+    bool startsWith(std::string_view prefix) const { return view().starts_with(prefix); }
+    bool operator==(std::string_view other) const { return view() == other; }
+    bool operator==(const Field& other) const { return view() == other.view(); }
+    bool operator<(const Field& other) const { return view() < other.view(); }
+
+    /* calls f with each delim-separated piece (the pieces aren't null-terminated) */
+    template <typename F>
+    void forEachPart(char delim, F f) const {
+	std::string_view rest { view() };
+	while (true) {
+	    auto pos = rest.find(delim);
+	    f(rest.substr(0, pos));
+	    if (pos == std::string_view::npos) break;
+	    rest.remove_prefix(pos+1);
+	}
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const Field& field) { return os << field.view(); }
+
+/* the fields of one row, also living in the arena */
+class Fields {
+private:
+    const Field* fields {};
+    uint32_t count {0};
+public:
+    Fields() {};
+    Fields(const Field* fields, uint32_t count): fields(fields), count(count) {};
+    int size() const { return static_cast<int>(count); }
+    const Field& operator[](int i) const { return fields[i]; }
+    const Field& at(int i) const {
+	if (i < 0 || static_cast<uint32_t>(i) >= count) throw std::out_of_range("Fields::at");
+	return fields[i];
+    }
+    const Field* begin() const { return fields; }
+    const Field* end() const { return fields + count; }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const Fields& row) {
+    os << '[';
+    for (auto& field : row) os << field << ',';
+    return os << ']';
+}
+
+/* bump allocator for row storage. a row costs two pointer bumps instead of a string
+ * (and a heap allocation) per field, and everything goes back at once on clear() or
+ * when the arena dies <== 10/19/26 11:02:31 */
+class RowArena {
+private:
+    static constexpr size_t BLOCK_SIZE = 1 << 22;
+    struct Block { std::unique_ptr<char[]> data; size_t size; };
+    std::vector<Block> blocks {};
+    size_t current {0};
+    size_t used {0};
+
+    char* alloc(size_t n, size_t align) {
+	while (true) {
+	    if (current < blocks.size()) {
+		size_t start = (used + align - 1) & ~(align - 1);
+		if (start + n <= blocks[current].size) {
+		    used = start + n;
+		    return blocks[current].data.get() + start;
+		}
+		if (current + 1 < blocks.size()) { ++current; used = 0; continue; }
+	    }
+	    size_t size = std::max(BLOCK_SIZE, n + align);
+	    blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+	    current = blocks.size() - 1;
+	    used = 0;
+	}
+    }
+public:
+    struct Mark { size_t block; size_t used; };
+
+    RowArena() {};
+    RowArena(const RowArena&) = delete;
+    RowArena& operator=(const RowArena&) = delete;
+    RowArena(RowArena&&) = default;
+    RowArena& operator=(RowArena&&) = default;
+
+    /* copies line in once and slices it on delim */
+    Fields split(std::string_view line, char delim = '\t') {
+	uint32_t count = 1 + std::count(line.begin(), line.end(), delim);
+	char* chars = alloc(line.size() + 1, 1);
+	Field* fields = reinterpret_cast<Field*>(alloc(count * sizeof(Field), alignof(Field)));
+	std::memcpy(chars, line.data(), line.size());
+	chars[line.size()] = '\0';
+	uint32_t field = 0;
+	size_t start = 0;
+	for (size_t i = 0; i <= line.size(); ++i) {
+	    if (i == line.size() || chars[i] == delim) {
+		chars[i] = '\0';
+		new (&fields[field++]) Field(chars + start, static_cast<uint32_t>(i - start));
+		start = i+1;
+	    }
+	}
+	return { fields, count };
+    }
+
+    Field copy(std::string_view str) {
+	char* chars = alloc(str.size() + 1, 1);
+	std::memcpy(chars, str.data(), str.size());
+	chars[str.size()] = '\0';
+	return { chars, static_cast<uint32_t>(str.size()) };
+    }
+
+    /* mark()/rewind() hand back whatever was allocated in between (rows we turned down) */
+    Mark mark() const { return { current, used }; }
+    void rewind(Mark m) { current = m.block; used = m.used; }
+
+    /* keeps the blocks around for the next batch */
+    RowArena& clear() { current = 0; used = 0; return *this; }
+
+    size_t capacity() const {
+	size_t total {0};
+	for (auto& block : blocks) total += block.size;
+	return total;
+    }
+};
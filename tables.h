@@ -0,0 +1,536 @@
+#pragma once
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <cstdint>
+#include <array>
+#include <tuple>
+#include <vector>
+#include <set>
+#include <string_view>
+#include <functional>
+#include <type_traits>
+
+/* the database's tables, described once. the CREATE TABLE and INSERT text is built from
+ * these at compile time, and rows are bound as a tuple of each column's C++ type, so a
+ * loader that disagrees with its table doesn't compile <== 10/19/26 14:22:40 */
+
+using Text = const char*;   /* nullptr binds NULL */
+
+template <typename T>
+struct Column {
+    std::string_view name;
+    std::string_view decl;
+    using type = T;
+};
+
+template <typename Columns> struct RowOf;
+template <typename... T> struct RowOf<std::tuple<Column<T>...>> { using type = std::tuple<T...>; };
+
+template <typename Table>
+using Row = typename RowOf<std::remove_cv_t<decltype(Table::columns)>>::type;
+
+/* a table's Col enum is looked up here by column name, so renaming or dropping a column
+ * the loaders still use is a compile error instead of a shifted index */
+template <typename... T>
+constexpr int columnIndex(const std::tuple<Column<T>...>& columns, std::string_view name) {
+    int found {-1};
+    int i {0};
+    std::apply([&](const auto&... column) {
+	((found = column.name == name ? i : found, ++i), ...);
+    }, columns);
+    if (found < 0) throw "no such column";
+    return found;
+}
+
+/* the names have to be distinct for columnIndex to mean anything */
+template <typename Table>
+constexpr bool describedBy() {
+    constexpr size_t count = std::tuple_size_v<Row<Table>>;
+    std::array<std::string_view, count> names = std::apply([](const auto&... column) {
+	return std::array<std::string_view, count> { column.name... };
+    }, Table::columns);
+    for (size_t i = 0; i < count; ++i) {
+	for (size_t j = i + 1; j < count; ++j) if (names[i] == names[j]) return false;
+    }
+    return Table::COLUMNS == count;
+}
+
+struct FilmsTable {
+    static constexpr std::string_view name = "Films";
+    static constexpr std::tuple columns {
+	Column<Text> { "tconst", "TEXT NOT NULL PRIMARY KEY" },
+	Column<Text> { "title", "TEXT NOT NULL" },
+	Column<Text> { "originalTitle", "TEXT NOT NULL" },
+    };
+    enum Col {
+	TCONST = columnIndex(columns, "tconst"),
+	TITLE = columnIndex(columns, "title"),
+	ORIGINAL_TITLE = columnIndex(columns, "originalTitle"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array<std::string_view, 0> constraints {};
+};
+
+struct GenresTable {
+    static constexpr std::string_view name = "Genres";
+    static constexpr std::tuple columns {
+	Column<Text> { "tconst", "TEXT NOT NULL" },
+	Column<Text> { "genre", "TEXT NOT NULL" },
+    };
+    enum Col {
+	TCONST = columnIndex(columns, "tconst"),
+	GENRE = columnIndex(columns, "genre"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array constraints {
+	std::string_view { "FOREIGN KEY (tconst) REFERENCES Films (tconst)" },
+    };
+};
+
+struct RuntimesTable {
+    static constexpr std::string_view name = "Runtimes";
+    static constexpr std::tuple columns {
+	Column<Text> { "tconst", "TEXT NOT NULL" },
+	Column<int> { "runtimeInMin", "INT NOT NULL" },
+    };
+    enum Col {
+	TCONST = columnIndex(columns, "tconst"),
+	RUNTIME = columnIndex(columns, "runtimeInMin"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array constraints {
+	std::string_view { "FOREIGN KEY (tconst) REFERENCES Films (tconst)" },
+	std::string_view { "UNIQUE(tconst, runtimeInMin)" },
+    };
+};
+
+struct YearsTable {
+    static constexpr std::string_view name = "Years";
+    static constexpr std::tuple columns {
+	Column<Text> { "tconst", "TEXT NOT NULL" },
+	Column<int> { "year", "INT NOT NULL" },
+    };
+    enum Col {
+	TCONST = columnIndex(columns, "tconst"),
+	YEAR = columnIndex(columns, "year"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array constraints {
+	std::string_view { "FOREIGN KEY (tconst) REFERENCES Films (tconst)" },
+	std::string_view { "UNIQUE(tconst, year)" },
+    };
+};
+
+struct NamesTable {
+    static constexpr std::string_view name = "Names";
+    static constexpr std::tuple columns {
+	Column<Text> { "nconst", "TEXT NOT NULL PRIMARY KEY" },
+	Column<Text> { "name", "TEXT NOT NULL" },
+    };
+    enum Col {
+	NCONST = columnIndex(columns, "nconst"),
+	NAME = columnIndex(columns, "name"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array constraints {
+	std::string_view { "UNIQUE(nconst, name)" },
+    };
+};
+
+/* Directors, Actors and Writers only differ in name */
+struct CreditsColumns {
+    static constexpr std::tuple columns {
+	Column<Text> { "tconst", "TEXT NOT NULL" },
+	Column<Text> { "nconst", "TEXT NOT NULL" },
+    };
+    enum Col {
+	TCONST = columnIndex(columns, "tconst"),
+	NCONST = columnIndex(columns, "nconst"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array constraints {
+	std::string_view { "FOREIGN KEY (tconst) REFERENCES Films (tconst)" },
+	std::string_view { "FOREIGN KEY (nconst) REFERENCES Names (nconst)" },
+	std::string_view { "UNIQUE(tconst,nconst)" },
+    };
+};
+struct DirectorsTable : CreditsColumns { static constexpr std::string_view name = "Directors"; };
+struct ActorsTable : CreditsColumns { static constexpr std::string_view name = "Actors"; };
+struct WritersTable : CreditsColumns { static constexpr std::string_view name = "Writers"; };
+
+struct CannesTable {
+    static constexpr std::string_view name = "Cannes";
+    static constexpr std::tuple columns {
+	Column<Text> { "tconst", "TEXT NOT NULL UNIQUE" },
+    };
+    enum Col {
+	TCONST = columnIndex(columns, "tconst"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array constraints {
+	std::string_view { "FOREIGN KEY (tconst) REFERENCES Films (tconst)" },
+    };
+};
+
+struct RatingsTable {
+    static constexpr std::string_view name = "Ratings";
+    static constexpr std::tuple columns {
+	Column<Text> { "tconst", "TEXT NOT NULL UNIQUE" },
+	Column<double> { "rating", "FLOAT NOT NULL" },
+	Column<int> { "numVotes", "INTEGER NOT NULL" },
+    };
+    enum Col {
+	TCONST = columnIndex(columns, "tconst"),
+	RATING = columnIndex(columns, "rating"),
+	NUMVOTES = columnIndex(columns, "numVotes"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array constraints {
+	std::string_view { "FOREIGN KEY (tconst) REFERENCES Films (tconst)" },
+    };
+};
+
+struct LanguagesTable {
+    static constexpr std::string_view name = "Languages";
+    static constexpr std::tuple columns {
+	Column<Text> { "tconst", "TEXT NOT NULL" },
+	Column<Text> { "lang", "TEXT NOT NULL" },
+    };
+    enum Col {
+	TCONST = columnIndex(columns, "tconst"),
+	LANG = columnIndex(columns, "lang"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array constraints {
+	std::string_view { "FOREIGN KEY (tconst) REFERENCES Films (tconst)" },
+    };
+};
+
+/* cannes.tsv rows already resolved, keyed by normalized title and director. a NULL
+ * tconst records that nothing matched */
+struct CannesMatchCacheTable {
+    static constexpr std::string_view name = "CannesMatchCache";
+    static constexpr std::tuple columns {
+	Column<Text> { "title", "TEXT NOT NULL" },
+	Column<Text> { "director", "TEXT NOT NULL" },
+	Column<Text> { "tconst", "TEXT" },
+	Column<Text> { "method", "TEXT NOT NULL" },
+	Column<double> { "score", "FLOAT NOT NULL" },
+    };
+    enum Col {
+	TITLE = columnIndex(columns, "title"),
+	DIRECTOR = columnIndex(columns, "director"),
+	TCONST = columnIndex(columns, "tconst"),
+	METHOD = columnIndex(columns, "method"),
+	SCORE = columnIndex(columns, "score"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array constraints {
+	std::string_view { "PRIMARY KEY (title, director)" },
+    };
+};
+
+struct LoadCheckpointsTable {
+    static constexpr std::string_view name = "LoadCheckpoints";
+    static constexpr std::tuple columns {
+	Column<Text> { "stage", "TEXT NOT NULL PRIMARY KEY" },
+	Column<Text> { "file", "TEXT NOT NULL" },
+	Column<int64_t> { "fileSize", "INTEGER NOT NULL" },
+	Column<int64_t> { "fileMtime", "INTEGER NOT NULL" },
+	Column<int64_t> { "byteOffset", "INTEGER NOT NULL" },
+	Column<int64_t> { "rowCount", "INTEGER NOT NULL" },
+	Column<int> { "complete", "INT NOT NULL" },
+    };
+    enum Col {
+	STAGE = columnIndex(columns, "stage"),
+	FILE = columnIndex(columns, "file"),
+	FILESIZE = columnIndex(columns, "fileSize"),
+	FILEMTIME = columnIndex(columns, "fileMtime"),
+	BYTEOFFSET = columnIndex(columns, "byteOffset"),
+	ROWCOUNT = columnIndex(columns, "rowCount"),
+	COMPLETE = columnIndex(columns, "complete"),
+	COLUMNS = std::tuple_size_v<decltype(columns)>
+    };
+    static constexpr std::array<std::string_view, 0> constraints {};
+};
+
+/* writes into out when there is one and counts either way, so the same code sizes the
+ * array and then fills it */
+struct SqlWriter {
+    char* out {};
+    size_t len {0};
+    constexpr void put(std::string_view s) {
+	for (char c : s) {
+	    if (out != nullptr) out[len] = c;
+	    ++len;
+	}
+    }
+};
+
+template <typename Table>
+constexpr void writeColumnNames(SqlWriter& w) {
+    bool first = true;
+    std::apply([&](const auto&... column) {
+	((w.put(first ? "" : ", "), w.put(column.name), first = false), ...);
+    }, Table::columns);
+}
+
+template <typename Table>
+constexpr void writeCreate(SqlWriter& w) {
+    w.put("CREATE TABLE IF NOT EXISTS \"");
+    w.put(Table::name);
+    w.put("\" (");
+    bool first = true;
+    std::apply([&](const auto&... column) {
+	((w.put(first ? "\n    " : ",\n    "), w.put(column.name), w.put(" "), w.put(column.decl), first = false), ...);
+    }, Table::columns);
+    for (auto constraint : Table::constraints) {
+	w.put(",\n    ");
+	w.put(constraint);
+    }
+    w.put(")");
+}
+
+/* UPDATE is an upsert: a row whose key is already there overwrites its other columns in place,
+ * which unlike REPLACE doesn't delete a row other tables' foreign keys point at */
+enum class OnConflict { ABORT, IGNORE, REPLACE, UPDATE };
+
+template <typename Table, int Rows, OnConflict conflict>
+constexpr void writeInsert(SqlWriter& w) {
+    if (conflict == OnConflict::IGNORE) w.put("INSERT OR IGNORE INTO ");
+    else if (conflict == OnConflict::REPLACE) w.put("INSERT OR REPLACE INTO ");
+    else w.put("INSERT INTO ");
+    w.put(Table::name);
+    w.put(" (");
+    writeColumnNames<Table>(w);
+    w.put(") VALUES ");
+    for (int row = 0; row < Rows; ++row) {
+	w.put(row == 0 ? "(" : ", (");
+	for (int col = 0; col < Table::COLUMNS; ++col) w.put(col == 0 ? "?" : ", ?");
+	w.put(")");
+    }
+    if (conflict == OnConflict::UPDATE) {
+	/* the key (the first column) stays out of the SET: writing it, even to the same value,
+	 * counts as changing a parent key, and sqlite then scans every child table for it */
+	int col = 0;
+	std::apply([&](const auto&... column) {
+	    ((col == 0 ? (w.put(" ON CONFLICT("), w.put(column.name), w.put(") DO UPDATE SET "))
+		: (w.put(col == 1 ? "" : ", "), w.put(column.name), w.put(" = excluded."), w.put(column.name)), ++col), ...);
+	}, Table::columns);
+    }
+}
+
+template <typename Table>
+constexpr void writeSelect(SqlWriter& w) {
+    w.put("SELECT ");
+    writeColumnNames<Table>(w);
+    w.put(" FROM ");
+    w.put(Table::name);
+}
+
+template <typename Table>
+constexpr void writeDelete(SqlWriter& w) {
+    w.put("DELETE FROM \"");
+    w.put(Table::name);
+    w.put("\"");
+}
+
+template <auto Write>
+constexpr auto sqlText() {
+    constexpr size_t size = [](){ SqlWriter w {}; Write(w); return w.len; }();
+    std::array<char, size + 1> text {};
+    SqlWriter w { text.data() };
+    Write(w);
+    return text;
+}
+
+template <typename Table>
+inline constexpr auto createText = sqlText<[](SqlWriter& w){ writeCreate<Table>(w); }>();
+
+template <typename Table, int Rows = 1, OnConflict conflict = OnConflict::ABORT>
+inline constexpr auto insertText = sqlText<[](SqlWriter& w){ writeInsert<Table, Rows, conflict>(w); }>();
+
+template <typename Table>
+inline constexpr auto selectText = sqlText<[](SqlWriter& w){ writeSelect<Table>(w); }>();
+
+template <typename Table>
+inline constexpr auto deleteText = sqlText<[](SqlWriter& w){ writeDelete<Table>(w); }>();
+
+template <typename Table>
+const char* createSql() {
+    static_assert(describedBy<Table>(), "column enum and column list disagree");
+    return createText<Table>.data();
+}
+
+template <typename Table, int Rows = 1, OnConflict conflict = OnConflict::ABORT>
+const char* insertSql() {
+    static_assert(describedBy<Table>(), "column enum and column list disagree");
+    static_assert(Rows * Table::COLUMNS <= 999, "more variables than sqlite allows in one statement");
+    return insertText<Table, Rows, conflict>.data();
+}
+
+template <typename Table>
+const char* selectSql() {
+    static_assert(describedBy<Table>(), "column enum and column list disagree");
+    return selectText<Table>.data();
+}
+
+template <typename... Tables>
+void createTables(SQLite::Database& db) {
+    (db.exec(createSql<Tables>()), ...);
+}
+
+/* empties the tables a stage is about to load from the top */
+template <typename... Tables>
+void clearTables(SQLite::Database& db) {
+    (db.exec(deleteText<Tables>.data()), ...);
+}
+
+/* text isn't copied: whatever it points at has to outlive the step */
+inline void bindValue(SQLite::Statement& statement, int i, Text value) {
+    if (value == nullptr) statement.bind(i);
+    else statement.bindNoCopy(i, value);
+}
+inline void bindValue(SQLite::Statement& statement, int i, int value) { statement.bind(i, value); }
+inline void bindValue(SQLite::Statement& statement, int i, int64_t value) { statement.bind(i, value); }
+inline void bindValue(SQLite::Statement& statement, int i, double value) { statement.bind(i, value); }
+
+/* binds one row starting at parameter first */
+template <typename Table>
+void bindRow(SQLite::Statement& statement, const Row<Table>& row, int first = 1) {
+    std::apply([&](const auto&... value) {
+	int i = first;
+	(bindValue(statement, i++, value), ...);
+    }, row);
+}
+
+class PendingRows {
+private:
+    std::vector<PendingRows*> children {};
+protected:
+    /* rows just went in, so children waiting on them may have full statements now */
+    void wake() { for (auto child : children) child->ready(); }
+public:
+    virtual void flush() = 0;
+    virtual void ready() = 0;
+    /* rows are numbered from 0 as they're added; everything below tried() has gone in or
+     * been turned down */
+    virtual long added() const = 0;
+    virtual long tried() const = 0;
+    virtual bool rejected(long row) const = 0;
+    void adopt(PendingRows* child) { children.push_back(child); }
+    virtual ~PendingRows() {}
+};
+
+/* queues rows and inserts them Rows at a time with one multi-row INSERT OR IGNORE (or
+ * whichever conflict is given), so the VM runs once per Rows rows instead of once per row.
+ * if that step fails (a foreign key, usually) the rows go in one at a time and only the
+ * bad ones are lost, as when every row had its own statement.
+ *
+ * rows referencing another queue's table name it as parent. each row belongs to the parent
+ * row added last before it and waits until that one has been tried, so the parent's own
+ * full statements drive its children's; a row whose parent row was turned down is dropped
+ * rather than left to hang off an older row with the same key. nothing is inserted until
+ * flush() or a full statement's worth of rows that aren't waiting */
+template <typename Table, int Rows = 64, OnConflict conflict = OnConflict::IGNORE>
+class BatchInsert : public PendingRows {
+private:
+    SQLite::Statement many;
+    SQLite::Statement one;
+    std::vector<Row<Table>> pending {};
+    std::function<void(const SQLite::Exception&)> onReject {};
+    PendingRows* parent {};
+    /* each pending row's number, and the parent row it belongs to */
+    std::vector<long> numbers {};
+    std::vector<long> owners {};
+    long count {0};
+    std::set<long> turnedDown {};
+
+    /* a full statement's worth, if its last row's parent row has been tried */
+    bool full() const {
+	return pending.size() >= Rows && (parent == nullptr || owners[Rows-1] < parent->tried());
+    }
+
+    void insertOne(size_t i) {
+	try {
+	    one.tryReset();
+	    bindRow<Table>(one, pending[i]);
+	    one.exec();
+	} catch (SQLite::Exception& e) {
+	    turnedDown.insert(numbers[i]);
+	    if (onReject) onReject(e);
+	}
+    }
+
+    /* inserts the rows no longer waiting on a parent row, Rows at a time, and with all the
+     * ones left over after the last full statement as well */
+    void insert(bool all) {
+	size_t ready = pending.size();
+	if (parent != nullptr) {
+	    long through = parent->tried();
+	    size_t kept {0};
+	    ready = 0;
+	    for (size_t i = 0; i < pending.size(); ++i) {
+		bool waiting = owners[i] >= through;
+		if (!waiting && parent->rejected(owners[i])) {
+		    turnedDown.insert(numbers[i]);
+		    continue;
+		}
+		if (!waiting) ++ready;
+		pending[kept] = pending[i];
+		numbers[kept] = numbers[i];
+		owners[kept++] = owners[i];
+	    }
+	    pending.resize(kept);
+	    numbers.resize(kept);
+	    owners.resize(kept);
+	}
+	size_t done {0};
+	for (; ready - done >= static_cast<size_t>(Rows); done += Rows) {
+	    try {
+		many.tryReset();
+		for (int row = 0; row < Rows; ++row) bindRow<Table>(many, pending[done + row], 1 + row*Table::COLUMNS);
+		many.exec();
+		continue;
+	    } catch (SQLite::Exception&) {
+		/* falls through to one row at a time */
+	    }
+	    for (size_t i = done; i < done + Rows; ++i) insertOne(i);
+	}
+	if (all) {
+	    for (; done < ready; ++done) insertOne(done);
+	}
+	if (done == 0) return;
+	pending.erase(pending.begin(), pending.begin() + done);
+	numbers.erase(numbers.begin(), numbers.begin() + done);
+	if (parent != nullptr) owners.erase(owners.begin(), owners.begin() + done);
+	wake();
+    }
+public:
+    BatchInsert(SQLite::Database& db, std::function<void(const SQLite::Exception&)> onReject = nullptr, PendingRows* parent = nullptr)
+	: many { db, insertSql<Table, Rows, conflict>() }, one { db, insertSql<Table, 1, conflict>() },
+	  onReject(std::move(onReject)), parent(parent) {
+	pending.reserve(Rows);
+	if (parent != nullptr) parent->adopt(this);
+    }
+    BatchInsert(const BatchInsert&) = delete;
+    BatchInsert& operator=(const BatchInsert&) = delete;
+
+    void add(const Row<Table>& row) {
+	pending.push_back(row);
+	numbers.push_back(count++);
+	if (parent != nullptr) owners.push_back(parent->added() - 1);
+	if (full()) insert(false);
+    }
+
+    /* everything, the parent's rows first */
+    void flush() override {
+	if (parent != nullptr) parent->flush();
+	insert(true);
+    }
+
+    void ready() override { if (full()) insert(false); }
+
+    long added() const override { return count; }
+    long tried() const override { return numbers.empty() ? count : numbers.front(); }
+    bool rejected(long row) const override { return turnedDown.contains(row); }
+};
@@ -0,0 +1,420 @@
+#pragma once
+#include <sqlite3.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <utility>
+#include <fstream>
+#include <filesystem>
+#include "imdbid.h"
+
+/* read-only sqlite virtual tables straight over the IMDb TSV dumps, so a few lookups
+ * don't need the whole import first:
+ *
+ *     CREATE VIRTUAL TABLE basics USING imdbtsv('/path/title.basics.tsv');
+ *
+ * the file is mmap'd and the columns come from its header line. equality on the first
+ * column (tconst or nconst in every dump) goes through a sidecar index, <file>.idx,
+ * holding the offset of each key's first row; it's built on first use and rebuilt
+ * whenever the file's size or mtime changes <== 10/19/26 13:31:09
+ *
+ * the index is only opened by a query that looks a key up, and then it's mmap'd and
+ * binary-searched where it lies, so a scan (or a table the query never touches) costs
+ * nothing for it */
+
+struct TsvIndexEntry {
+    uint64_t key;
+    uint64_t offset;
+};
+
+class TsvFile {
+private:
+    static constexpr char MAGIC[8] = { 'B','M','D','B','I','D','X','1' };
+    /* magic, file size, mtime, entry count */
+    static constexpr size_t HEADER_SIZE = 32;
+    int64_t mtime {0};
+    const char* idxData {};
+    size_t idxSize {0};
+    /* where entries point when the .idx couldn't be written and mapped back */
+    std::vector<TsvIndexEntry> built {};
+
+    bool mapIndex(const std::string& idxpath) {
+	int fd = ::open(idxpath.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st {};
+	fstat(fd, &st);
+	size_t length = static_cast<size_t>(st.st_size);
+	void* mapped = length >= HEADER_SIZE ? mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+	::close(fd);
+	if (mapped == MAP_FAILED) return false;
+	const char* header = static_cast<const char*>(mapped);
+	uint64_t fileSize {0};
+	int64_t fileMtime {0};
+	uint64_t count {0};
+	std::memcpy(&fileSize, header + 8, sizeof fileSize);
+	std::memcpy(&fileMtime, header + 16, sizeof fileMtime);
+	std::memcpy(&count, header + 24, sizeof count);
+	if (std::memcmp(header, MAGIC, 8) != 0 || fileSize != size || fileMtime != mtime
+		|| length != HEADER_SIZE + count * sizeof(TsvIndexEntry)) {
+	    munmap(mapped, length);
+	    return false;
+	}
+	idxData = header;
+	idxSize = length;
+	entries = reinterpret_cast<const TsvIndexEntry*>(header + HEADER_SIZE);
+	entryCount = count;
+	return true;
+    }
+
+    /* one entry per run of rows sharing a key; the dumps are sorted, so that's one per key */
+    void buildIndex(const std::string& idxpath) {
+	built.clear();
+	long previous {-1};
+	for (size_t offset = bodyStart; offset < size; offset = lineEnd(offset) + 1) {
+	    long key = idNumber(firstField(offset));
+	    if (key >= 0 && key != previous) built.push_back({ static_cast<uint64_t>(key), offset });
+	    previous = key;
+	}
+	std::stable_sort(built.begin(), built.end(), [](const TsvIndexEntry& a, const TsvIndexEntry& b) { return a.key < b.key; });
+
+	/* best effort: a read-only directory just means building it again next time */
+	std::string tmppath { idxpath + ".tmp" };
+	std::ofstream out { tmppath, std::ios::binary | std::ios::trunc };
+	uint64_t fileSize { size };
+	uint64_t count { built.size() };
+	out.write(MAGIC, 8);
+	out.write(reinterpret_cast<const char*>(&fileSize), sizeof fileSize);
+	out.write(reinterpret_cast<const char*>(&mtime), sizeof mtime);
+	out.write(reinterpret_cast<const char*>(&count), sizeof count);
+	out.write(reinterpret_cast<const char*>(built.data()), count * sizeof(TsvIndexEntry));
+	out.close();
+	std::error_code ec {};
+	if (out) std::filesystem::rename(tmppath, idxpath, ec);
+	else std::filesystem::remove(tmppath, ec);
+	if (!out || ec || !mapIndex(idxpath)) {
+	    entries = built.data();
+	    entryCount = built.size();
+	}
+	else built.clear();
+    }
+public:
+    std::string path {};
+    const char* data {};
+    size_t size {0};
+    size_t bodyStart {0};
+    std::vector<std::string> columns {};
+    const TsvIndexEntry* entries {};
+    size_t entryCount {0};
+    bool indexed {false};
+
+    TsvFile() {};
+    TsvFile(const TsvFile&) = delete;
+    TsvFile& operator=(const TsvFile&) = delete;
+    ~TsvFile() {
+	if (data != nullptr && size > 0) munmap(const_cast<char*>(data), size);
+	if (idxData != nullptr) munmap(const_cast<char*>(idxData), idxSize);
+    }
+
+    bool open(const std::string& filepath, std::string& error) {
+	path = filepath;
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+	    error = "cannot open " + path + ": " + std::strerror(errno);
+	    return false;
+	}
+	struct stat st {};
+	fstat(fd, &st);
+	size = static_cast<size_t>(st.st_size);
+	mtime = static_cast<int64_t>(st.st_mtime);
+	if (size > 0) {
+	    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	    if (mapped == MAP_FAILED) {
+		::close(fd);
+		error = "cannot mmap " + path + ": " + std::strerror(errno);
+		return false;
+	    }
+	    data = static_cast<const char*>(mapped);
+	}
+	::close(fd);
+	if (size == 0) {
+	    error = path + " is empty";
+	    return false;
+	}
+
+	size_t headerEnd = lineEnd(0);
+	std::string_view header { data, headerEnd };
+	while (true) {
+	    auto tab = header.find('\t');
+	    columns.emplace_back(header.substr(0, tab));
+	    if (tab == std::string_view::npos) break;
+	    header.remove_prefix(tab+1);
+	}
+	bodyStart = std::min(size, headerEnd + 1);
+	return true;
+    }
+
+    /* maps <file>.idx, building it first if it's missing or stale */
+    void ensureIndex() {
+	if (indexed) return;
+	std::string idxpath { path + ".idx" };
+	if (!mapIndex(idxpath)) buildIndex(idxpath);
+	indexed = true;
+    }
+
+    /* the offsets of the runs holding key, in file order */
+    std::pair<const TsvIndexEntry*, const TsvIndexEntry*> runsOf(uint64_t key) const {
+	return std::equal_range(entries, entries + entryCount, TsvIndexEntry { key, 0 },
+	    [](const TsvIndexEntry& a, const TsvIndexEntry& b) { return a.key < b.key; });
+    }
+
+    size_t lineEnd(size_t offset) const {
+	const void* newline = std::memchr(data + offset, '\n', size - offset);
+	return newline == nullptr ? size : static_cast<const char*>(newline) - data;
+    }
+
+    std::string_view firstField(size_t offset) const {
+	std::string_view line { data + offset, lineEnd(offset) - offset };
+	return line.substr(0, line.find('\t'));
+    }
+};
+
+struct TsvVtab : sqlite3_vtab {
+    TsvFile file {};
+    std::vector<bool> numeric {};
+};
+
+struct TsvCursor : sqlite3_vtab_cursor {
+    const TsvFile* file {};
+    size_t rowStart {0};
+    size_t rowEnd {0};
+    bool eof {true};
+    /* for key lookups: the key and the index runs still to visit */
+    bool keyed {false};
+    std::string key {};
+    std::vector<size_t> runs {};
+    size_t run {0};
+    std::vector<std::string_view> fields {};
+    bool split {false};
+
+    void at(size_t offset) {
+	rowStart = offset;
+	rowEnd = file->lineEnd(offset);
+	split = false;
+    }
+
+    /* lands on the next non-empty row, or the next run's first row, or eof */
+    void settle() {
+	while (true) {
+	    if (rowStart >= file->size) {
+		if (!keyed || run >= runs.size()) { eof = true; return; }
+		at(runs[run++]);
+		continue;
+	    }
+	    if (rowEnd == rowStart) { at(rowEnd + 1); continue; }
+	    if (keyed && file->firstField(rowStart) != key) {
+		if (run >= runs.size()) { eof = true; return; }
+		at(runs[run++]);
+		continue;
+	    }
+	    eof = false;
+	    return;
+	}
+    }
+
+    const std::vector<std::string_view>& row() {
+	if (!split) {
+	    fields.clear();
+	    std::string_view line { file->data + rowStart, rowEnd - rowStart };
+	    while (true) {
+		auto tab = line.find('\t');
+		fields.push_back(line.substr(0, tab));
+		if (tab == std::string_view::npos) break;
+		line.remove_prefix(tab+1);
+	    }
+	    split = true;
+	}
+	return fields;
+    }
+};
+
+inline int tsvConnect(sqlite3* db, void*, int argc, const char* const* argv, sqlite3_vtab** vtab, char** err) {
+    if (argc < 4) {
+	*err = sqlite3_mprintf("imdbtsv needs the path of a TSV file");
+	return SQLITE_ERROR;
+    }
+    std::string path { argv[3] };
+    if (path.size() >= 2 && (path.front() == '\'' || path.front() == '"') && path.back() == path.front()) {
+	/* a quote inside comes doubled, as runQuery writes it */
+	char quote = path.front();
+	std::string unquoted {};
+	for (size_t i = 1; i + 1 < path.size(); ++i) {
+	    unquoted += path[i];
+	    if (path[i] == quote && path[i+1] == quote) ++i;
+	}
+	path = unquoted;
+    }
+
+    auto table = new TsvVtab {};
+    std::string error {};
+    if (!table->file.open(path, error)) {
+	*err = sqlite3_mprintf("%s", error.c_str());
+	delete table;
+	return SQLITE_ERROR;
+    }
+
+    /* the count/year/rating columns come back as numbers, everything else as text */
+    static const std::set<std::string> numbers { "isAdult", "startYear", "endYear", "runtimeMinutes",
+	"averageRating", "numVotes", "ordering", "birthYear", "deathYear" };
+    std::string schema { "CREATE TABLE x(" };
+    for (size_t i = 0; i < table->file.columns.size(); ++i) {
+	if (i > 0) schema += ", ";
+	schema += "\"" + table->file.columns[i] + "\"";
+	table->numeric.push_back(numbers.contains(table->file.columns[i]));
+    }
+    schema += ")";
+    int rc = sqlite3_declare_vtab(db, schema.c_str());
+    if (rc != SQLITE_OK) {
+	delete table;
+	return rc;
+    }
+    *vtab = table;
+    return SQLITE_OK;
+}
+
+inline int tsvDisconnect(sqlite3_vtab* vtab) {
+    delete static_cast<TsvVtab*>(vtab);
+    return SQLITE_OK;
+}
+
+inline int tsvBestIndex(sqlite3_vtab* vtab, sqlite3_index_info* info) {
+    auto table = static_cast<TsvVtab*>(vtab);
+    for (int i = 0; i < info->nConstraint; ++i) {
+	const auto& constraint = info->aConstraint[i];
+	if (constraint.usable && constraint.iColumn == 0 && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+	    info->aConstraintUsage[i].argvIndex = 1;
+	    info->aConstraintUsage[i].omit = 1;
+	    info->idxNum = 1;
+	    info->estimatedCost = 10;
+	    info->estimatedRows = 10;
+	    return SQLITE_OK;
+	}
+    }
+    info->idxNum = 0;
+    info->estimatedCost = static_cast<double>(table->file.size);
+    info->estimatedRows = static_cast<sqlite3_int64>(table->file.size / 64);
+    return SQLITE_OK;
+}
+
+inline int tsvOpen(sqlite3_vtab* vtab, sqlite3_vtab_cursor** cursor) {
+    auto open = new TsvCursor {};
+    open->file = &static_cast<TsvVtab*>(vtab)->file;
+    *cursor = open;
+    return SQLITE_OK;
+}
+
+inline int tsvClose(sqlite3_vtab_cursor* cursor) {
+    delete static_cast<TsvCursor*>(cursor);
+    return SQLITE_OK;
+}
+
+inline int tsvFilter(sqlite3_vtab_cursor* cursor, int idxNum, const char*, int argc, sqlite3_value** argv) {
+    auto cur = static_cast<TsvCursor*>(cursor);
+    cur->keyed = false;
+    cur->runs.clear();
+    cur->run = 0;
+    if (idxNum == 1 && argc > 0) {
+	cur->keyed = true;
+	const unsigned char* text = sqlite3_value_text(argv[0]);
+	long number = text == nullptr ? -1 : idNumber(reinterpret_cast<const char*>(text));
+	if (number < 0) {
+	    cur->eof = true;
+	    return SQLITE_OK;
+	}
+	cur->key = reinterpret_cast<const char*>(text);
+	TsvFile& file = static_cast<TsvVtab*>(cursor->pVtab)->file;
+	file.ensureIndex();
+	auto range = file.runsOf(static_cast<uint64_t>(number));
+	for (auto entry = range.first; entry != range.second; ++entry) cur->runs.push_back(entry->offset);
+	if (cur->runs.empty()) {
+	    cur->eof = true;
+	    return SQLITE_OK;
+	}
+	cur->at(cur->runs[cur->run++]);
+    }
+    else {
+	cur->at(cur->file->bodyStart);
+    }
+    cur->settle();
+    return SQLITE_OK;
+}
+
+inline int tsvNext(sqlite3_vtab_cursor* cursor) {
+    auto cur = static_cast<TsvCursor*>(cursor);
+    cur->at(cur->rowEnd + 1);
+    cur->settle();
+    return SQLITE_OK;
+}
+
+inline int tsvEof(sqlite3_vtab_cursor* cursor) {
+    return static_cast<TsvCursor*>(cursor)->eof ? 1 : 0;
+}
+
+inline int tsvColumn(sqlite3_vtab_cursor* cursor, sqlite3_context* ctx, int col) {
+    auto cur = static_cast<TsvCursor*>(cursor);
+    auto table = static_cast<TsvVtab*>(cursor->pVtab);
+    const auto& fields = cur->row();
+    if (col < 0 || static_cast<size_t>(col) >= fields.size() || fields[col] == R"(\N)") {
+	sqlite3_result_null(ctx);
+	return SQLITE_OK;
+    }
+    std::string_view field { fields[col] };
+    if (table->numeric[col]) {
+	double number {0};
+	auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), number);
+	if (ec == std::errc() && end == field.data() + field.size()) {
+	    if (field.find('.') == std::string_view::npos) sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(number));
+	    else sqlite3_result_double(ctx, number);
+	    return SQLITE_OK;
+	}
+    }
+    /* the mapping outlives every value we hand out, so no copy */
+    sqlite3_result_text(ctx, field.data(), static_cast<int>(field.size()), SQLITE_STATIC);
+    return SQLITE_OK;
+}
+
+inline int tsvRowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid) {
+    *rowid = static_cast<sqlite3_int64>(static_cast<TsvCursor*>(cursor)->rowStart);
+    return SQLITE_OK;
+}
+
+/* makes "imdbtsv" available on db */
+inline int registerTsvModule(sqlite3* db) {
+    static sqlite3_module module = [](){
+	sqlite3_module m {};
+	m.iVersion = 0;
+	m.xCreate = tsvConnect;
+	m.xConnect = tsvConnect;
+	m.xBestIndex = tsvBestIndex;
+	m.xDisconnect = tsvDisconnect;
+	m.xDestroy = tsvDisconnect;
+	m.xOpen = tsvOpen;
+	m.xClose = tsvClose;
+	m.xFilter = tsvFilter;
+	m.xNext = tsvNext;
+	m.xEof = tsvEof;
+	m.xColumn = tsvColumn;
+	m.xRowid = tsvRowid;
+	return m;
+    }();
+    return sqlite3_create_module(db, "imdbtsv", &module, nullptr);
+}